@@ -1,6 +1,9 @@
 #include "includes.h"
 #include <scoped_allocator>
 
+#include "MmapAllocator.h"
+#include "PersistentVector.h"
+
 template <class Tp>
 struct SimpleAllocator 
 {
@@ -112,51 +115,6 @@ template <class T, class U>
 bool operator!=(const Mallocator<T>&, const Mallocator<U>&) { return false; }
 
 
-namespace mmap_allocator_namespace
-{
-	// See StackOverflow replies to this answer for important commentary about inheriting from std::allocator before replicating this code.
-	template <typename T>
-	class mmap_allocator : public std::allocator<T>
-	{
-	public:
-		template<typename _Tp1>
-		struct rebind
-		{
-			typedef mmap_allocator<_Tp1> other;
-		};
-
-		T* allocate(size_t N, const void* hint = nullptr)
-		{
-			fprintf(stderr, "Alloc %d bytes.\n", N * sizeof(T));
-			return std::allocator<T>::allocate(N, hint);
-		}
-
-		void deallocate(T* pointer, size_t N)
-		{
-			fprintf(stderr, "Dealloc %d bytes (%p).\n", N * sizeof(T), pointer);
-			return std::allocator<T>::deallocate(pointer, N);
-		}
-
-		mmap_allocator() 
-			throw() : std::allocator<T>()
-		{
-			fprintf(stderr, "Hello allocator!\n");
-		}
-		
-		mmap_allocator(const mmap_allocator& a) 
-			throw() : std::allocator<T>(a)
-		{ }
-		
-		template <class U>
-		mmap_allocator(const mmap_allocator<U>& a) 
-			throw() : std::allocator<T>(a)
-		{ }
-		~mmap_allocator() 
-			throw()
-		{ }
-	};
-}
-
 int mainAlloc()
 {
 	
@@ -214,7 +172,7 @@ int mainAlloc()
 	//std::vector<char, std::allocator<char>> vectChar;
 
 	int sz_ = 1024 * 1024;
-	vector<int, mmap_allocator_namespace::mmap_allocator<int> > int_vec(sz_, 0, mmap_allocator_namespace::mmap_allocator<int>());
+	vector<int, MmapAllocator<int> > int_vec(sz_, 0, MmapAllocator<int>());
 	vector<int, Mallocator<int>> m_vec(sz_, 0, Mallocator<int>());
 	vector<int> def_vec;
 
@@ -225,6 +183,23 @@ int mainAlloc()
 	//for (int b = 0; b < 1024; b++)
 	//	int_vec.emplace_back(b);
 
+	// Past the first MB the buffer is mremap'd, no element is copied while it grows
+	MmapVector<int, 1 << 20, VirtualMemory::Sequential> big_vec;
+	for (int d = 0; d < sz_ * 64; d++)
+		big_vec.push_back(d);
+
+	// Built once, then every later start maps the file and uses the table as is
+	// 64-bit entries, e * e overflows int past 46340; a file of int entries is rejected by its header
+	PersistentVector<long long> squares("squares64.pvec");
+	if (squares.size() != static_cast<size_t>(sz_))
+	{
+		squares.clear();
+		for (int e = 0; e < sz_; e++)
+			squares.push_back(static_cast<long long>(e) * e);
+		squares.Flush();
+	}
+	std::cout << squares[sz_ / 2] << '\n';
+
 	//for (int c = 0; c < 1024; c++)
 	//	m_vec.emplace_back(c);
 
@@ -0,0 +1,275 @@
+#pragma once
+#include <stdlib.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#define TEMP_MALLOC malloc
+#define TEMP_FREE free
+#define TEMP_NEW_INPLACE(MEMORY) new(MEMORY)
+
+// Bump-pointer arena over a chain of malloc'd blocks. When the current block
+// cannot fit a request a new block is appended (a dedicated one for requests
+// larger than blockSize), so a spike never runs out of space. Rewinding to a
+// Marker pops every block appended after it; standard-size blocks are kept on
+// a spare list and reused by the next growth, oversized ones are freed.
+//
+// Free(ptr, size) gives back the top allocation of the current block, and a
+// buffer freed while the allocation right above it is still live is kept as a
+// hole that goes with that allocation. A growing container (allocate new,
+// move, free old) thus leaves one hole under its live buffer and hands the
+// whole run back when it is destroyed; Resize grows or shrinks the top
+// allocation in place for callers that own their buffer.
+class LinearAllocator
+{
+	struct alignas(std::max_align_t) Block
+	{
+		Block* prev;
+		size_t size;
+
+		char* Data() { return reinterpret_cast<char*>(this + 1); }
+	};
+
+public:
+	// Position to rewind to; taken by TempAllocatorScope
+	struct Marker
+	{
+		Block* block;
+		size_t offset;
+	};
+
+	LinearAllocator(size_t blockSize)
+		: m_BlockSize{ blockSize }
+		, m_Current{ NewBlock(blockSize) }
+	{}
+
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+	~LinearAllocator()
+	{
+		FreeChain(m_Current);
+		FreeChain(m_Spare);
+	}
+
+	void* Allocate(size_t size, unsigned alignment /* power of 2 */)
+	{
+		assert((alignment & (alignment - 1)) == 0);
+
+		const size_t aligned = AlignedOffset(m_Current, m_Offset, alignment);
+		if (aligned + size <= m_Current->size)
+		{
+			m_TopBegin = m_Offset;
+			m_TopStart = aligned;
+			m_Offset = aligned + size;
+			return m_Current->Data() + aligned;
+		}
+		return AllocateFromNewBlock(size, alignment);
+	}
+
+	// Reclaims ptr if it is the top allocation (together with the hole under it),
+	// or records it as a hole under the top allocation; otherwise a no-op until
+	// the next rewind
+	void Free(void* ptr, size_t size)
+	{
+		size_t offset;
+		if (!InCurrentBlock(ptr, offset))
+			return;
+
+		if (offset + size == m_Offset)
+		{
+			NotePeak();
+			m_Offset = offset == m_TopStart ? m_TopBegin : offset;
+			if (m_HoleNext == offset)
+				m_Offset = m_HoleBegin;
+			ForgetTop();
+		}
+		else if (offset + size == m_TopBegin)
+		{
+			// Extend the hole if ptr sits right on top of it
+			if (m_HoleNext != offset)
+				m_HoleBegin = offset;
+			m_HoleNext = m_TopStart;
+		}
+	}
+
+	// Grows or shrinks the top allocation in place; false if ptr is not the top
+	// allocation or the current block cannot hold newSize
+	bool Resize(void* ptr, size_t oldSize, size_t newSize)
+	{
+		size_t offset;
+		if (!InCurrentBlock(ptr, offset) || offset + oldSize != m_Offset || offset + newSize > m_Current->size)
+			return false;
+
+		NotePeak();
+		m_Offset = offset + newSize;
+		return true;
+	}
+
+	Marker GetMarker() const { return { m_Current, m_Offset }; }
+
+	// Frees everything allocated after the marker was taken
+	void Rewind(const Marker& marker)
+	{
+		NotePeak();
+		while (m_Current != marker.block)
+		{
+			assert(m_Current->prev != nullptr && "Marker does not belong to this allocator");
+			Block* block = m_Current;
+			m_Current = block->prev;
+			m_ChainBytes -= m_Current->size;
+			Recycle(block);
+		}
+		m_Offset = marker.offset;
+		ForgetTop();
+	}
+
+	// Rewinds to the first block
+	void Reset()
+	{
+		NotePeak();
+		while (m_Current->prev != nullptr)
+		{
+			Block* block = m_Current;
+			m_Current = block->prev;
+			Recycle(block);
+		}
+		m_ChainBytes = 0;
+		m_Offset = 0;
+		ForgetTop();
+	}
+
+	// Bytes between the first block's start and the bump pointer, tails left at block switches included
+	size_t UsedBytes() const { return m_ChainBytes + m_Offset; }
+
+	// Highest UsedBytes() since construction or ResetPeak()
+	size_t PeakBytes() const { return m_Peak > UsedBytes() ? m_Peak : UsedBytes(); }
+
+	void ResetPeak() { m_Peak = UsedBytes(); }
+
+	size_t CurrentFreeSpace() const { return m_Current->size - m_Offset; }
+
+	size_t BlockSize() const { return m_BlockSize; }
+
+	// Blocks the chain has grown by and blocks waiting on the spare list
+	size_t BlockCount() const { return CountChain(m_Current); }
+	size_t SpareBlockCount() const { return CountChain(m_Spare); }
+
+	// Returns the spare blocks to the system
+	void ReleaseSpare()
+	{
+		FreeChain(m_Spare);
+		m_Spare = nullptr;
+	}
+
+private:
+	static constexpr size_t NoOffset = ~size_t(0);
+
+	bool InCurrentBlock(const void* ptr, size_t& offset) const
+	{
+		const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+		const auto data = reinterpret_cast<std::uintptr_t>(m_Current->Data());
+		offset = address - data;
+		return address >= data && offset <= m_Offset;
+	}
+
+	// Called before the bump pointer moves down, so Allocate never has to
+	void NotePeak()
+	{
+		m_Peak = PeakBytes();
+	}
+
+	void ForgetTop()
+	{
+		m_TopBegin = m_TopStart = m_HoleNext = NoOffset;
+	}
+
+	static size_t AlignedOffset(Block* block, size_t offset, unsigned alignment)
+	{
+		const auto address = reinterpret_cast<std::uintptr_t>(block->Data()) + offset;
+		return offset + ((alignment - address % alignment) % alignment);
+	}
+
+	static Block* NewBlock(size_t size)
+	{
+		auto block = static_cast<Block*>(TEMP_MALLOC(sizeof(Block) + size));
+		assert(block != nullptr && "Linear allocator out of memory!");
+		block->prev = nullptr;
+		block->size = size;
+		return block;
+	}
+
+	static void FreeChain(Block* block)
+	{
+		while (block != nullptr)
+		{
+			Block* prev = block->prev;
+			TEMP_FREE(block);
+			block = prev;
+		}
+	}
+
+	static size_t CountChain(const Block* block)
+	{
+		size_t count = 0;
+		for (; block != nullptr; block = block->prev)
+			++count;
+		return count;
+	}
+
+	void* AllocateFromNewBlock(size_t size, unsigned alignment)
+	{
+		// Block data is max_align_t aligned, so only larger alignments need slack
+		const size_t needed = size + (alignment > alignof(std::max_align_t) ? alignment : 0);
+
+		Block* block;
+		if (needed <= m_BlockSize && m_Spare != nullptr)
+		{
+			block = m_Spare;
+			m_Spare = block->prev;
+		}
+		else
+		{
+			block = NewBlock(needed <= m_BlockSize ? m_BlockSize : needed);
+		}
+
+		m_ChainBytes += m_Current->size;
+		block->prev = m_Current;
+		m_Current = block;
+
+		const size_t aligned = AlignedOffset(m_Current, 0, alignment);
+		ForgetTop();
+		m_TopBegin = 0;
+		m_TopStart = aligned;
+		m_Offset = aligned + size;
+		return m_Current->Data() + aligned;
+	}
+
+	void Recycle(Block* block)
+	{
+		if (block->size == m_BlockSize)
+		{
+			block->prev = m_Spare;
+			m_Spare = block;
+		}
+		else
+		{
+			TEMP_FREE(block);
+		}
+	}
+
+	size_t m_BlockSize;
+	Block* m_Current;
+	Block* m_Spare = nullptr;
+	// Size of every block below the current one
+	size_t m_ChainBytes = 0;
+	size_t m_Offset = 0;
+	size_t m_Peak = 0;
+	// Top allocation of the current block: bump offset before and after aligning
+	size_t m_TopBegin = NoOffset;
+	size_t m_TopStart = NoOffset;
+	// Freed run [m_HoleBegin, m_TopBegin) under the allocation at m_HoleNext
+	size_t m_HoleBegin = 0;
+	size_t m_HoleNext = NoOffset;
+};
@@ -39,13 +39,31 @@ namespace JSON {
 
 	MVJSONReader::MVJSONReader(const string& source) {
 		root = nullptr;
-		if (source == "") return;
 
+		const char* p = source.c_str();
+		const char* end = p + source.length();
+		skipSpaces(p, end);
+		if (p == end) return;
 
-		if (source[0] == '{')
-			root = parse(source);
-		if (source[0] == '[')
-			root = parse("{\"root\":" + source + "}");
+		if (*p == '{')
+			root = parseObject(p, end);
+		else if (*p == '[')
+		{
+			MVJSONValue* array = parseArray("root", p, end);
+			if (array != NULL)
+			{
+				root = new MVJSONNode();
+				root->values.push_back(array);
+			}
+		}
+
+		// only spaces may follow the root
+		skipSpaces(p, end);
+		if ((root != NULL) && (p != end))
+		{
+			delete root;
+			root = nullptr;
+		}
 	}
 
 	MVJSONReader::~MVJSONReader() {
@@ -61,97 +79,260 @@ namespace JSON {
 
 
 
-	MVJSONNode * MVJSONReader::parse(string text)
+	void MVJSONReader::skipSpaces(const char*& p, const char* end)
 	{
-		string s = trim(text);
-		if (s.length() < 2) return NULL;
+		while ((p != end) && (symbolToBeTrimmed(*p))) p++;
+	}
 
-		// object
-		if ((s[0] == '{') && (s[s.length() - 1] == '}'))
+	bool MVJSONReader::parseLiteral(const char*& p, const char* end, const char* literal)
+	{
+		const char* s = p;
+		while (*literal)
 		{
-			// erase last and first symbols
-			s.erase(0, 1);
-			s.erase(s.length() - 1, 1);
+			if ((s == end) || (*s != *literal)) return false;
+			s++;
+			literal++;
+		}
+		p = s;
+		return true;
+	}
 
-			vector<string> parts;
-			splitList(s, parts);
+	/// append code point as utf-8
+	static void appendUtf8(string& result, unsigned int code)
+	{
+		if (code < 0x80)
+			result += (char)code;
+		else if (code < 0x800)
+		{
+			result += (char)(0xC0 | (code >> 6));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000)
+		{
+			result += (char)(0xE0 | (code >> 12));
+			result += (char)(0x80 | ((code >> 6) & 0x3F));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			result += (char)(0xF0 | (code >> 18));
+			result += (char)(0x80 | ((code >> 12) & 0x3F));
+			result += (char)(0x80 | ((code >> 6) & 0x3F));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+	}
 
-			MVJSONNode* node = new MVJSONNode();
+	/// read four hex digits of \u escape
+	static bool parseHex4(const char*& p, const char* end, unsigned int& code)
+	{
+		if (end - p < 4) return false;
+		code = 0;
+		for (int i = 0; i < 4; i++, p++)
+		{
+			code <<= 4;
+			if ((*p >= '0') && (*p <= '9')) code |= *p - '0';
+			else if ((*p >= 'a') && (*p <= 'f')) code |= *p - 'a' + 10;
+			else if ((*p >= 'A') && (*p <= 'F')) code |= *p - 'A' + 10;
+			else return false;
+		}
+		return true;
+	}
 
-			for (int i = 0; i < parts.size(); i++)
-				node->values.push_back(parseValue(parts.at(i), false));
+	bool MVJSONReader::parseString(const char*& p, const char* end, string& result)
+	{
+		p++; // "
+		result.clear();
+		for (;;)
+		{
+			// copy the run up to the next quote or escape in one go
+			const char* run = p;
+			while ((p != end) && (*p != '"') && (*p != '\\')) p++;
+			result.append(run, p - run);
+			if (p == end) return false;
 
-			return node;
-		}
+			if (*p == '"')
+			{
+				p++;
+				return true;
+			}
 
-		return NULL;
+			// here we switch back special chars
+			//	\"	\\	\/	\b	\f	\n	\r	\t	\u four-hex-digits
+			p++;
+			if (p == end) return false;
+			char c = *p++;
+			switch (c)
+			{
+			case '"': result += '"'; break;
+			case '\\': result += '\\'; break;
+			case '/': result += '/'; break;
+			case 'b': result += '\b'; break;
+			case 'f': result += '\f'; break;
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			case 't': result += '\t'; break;
+			case 'u':
+			{
+				unsigned int code;
+				if (!parseHex4(p, end, code)) return false;
+				// surrogate pair
+				if ((code >= 0xD800) && (code < 0xDC00) && (end - p >= 2) && (p[0] == '\\') && (p[1] == 'u'))
+				{
+					const char* low = p + 2;
+					unsigned int lowCode;
+					if (parseHex4(low, end, lowCode) && (lowCode >= 0xDC00) && (lowCode < 0xE000))
+					{
+						code = 0x10000 + ((code - 0xD800) << 10) + (lowCode - 0xDC00);
+						p = low;
+					}
+				}
+				appendUtf8(result, code);
+				break;
+			}
+			default: return false;
+			}
+		}
 	}
 
 
 
-
-	MVJSONValue* MVJSONReader::parseValue(string text, bool hasNoName)
+	MVJSONNode * MVJSONReader::parseObject(const char*& p, const char* end)
 	{
+		p++; // {
+		MVJSONNode* node = new MVJSONNode();
+
+		skipSpaces(p, end);
+		if ((p != end) && (*p == '}'))
+		{
+			p++;
+			return node;
+		}
+
 		string key;
-		string s;
-		splitInHalf(text, ":", key, s);
-		key = trim(key);
-		s = trim(s);
-		if (key.length() > 2)
+		for (;;)
 		{
-			// strip "
-			key.erase(0, 1);
-			key.erase(key.length() - 1, 1);
+			skipSpaces(p, end);
+			if ((p == end) || (*p != '"') || (!parseString(p, end, key))) break;
+
+			skipSpaces(p, end);
+			if ((p == end) || (*p != ':')) break;
+			p++;
+
+			MVJSONValue* value = parseValue(key, p, end);
+			if (value == NULL) break;
+			node->values.push_back(value);
+
+			skipSpaces(p, end);
+			if (p == end) break;
+			if (*p == ',') { p++; continue; }
+			if (*p == '}') { p++; return node; }
+			break;
 		}
 
-		if (hasNoName)
+		delete node;
+		return NULL;
+	}
+
+	MVJSONValue* MVJSONReader::parseArray(const string& name, const char*& p, const char* end)
+	{
+		p++; // [
+		MVJSONValue* val = new MVJSONValue(name, MVJSON_TYPE_ARRAY);
+
+		skipSpaces(p, end);
+		if ((p != end) && (*p == ']'))
 		{
-			s = text;
-			key = "";
+			p++;
+			return val;
 		}
 
+		for (;;)
+		{
+			MVJSONValue* item = parseValue("", p, end);
+			if (item == NULL) break;
+			val->arrayValue.push_back(item);
+
+			skipSpaces(p, end);
+			if (p == end) break;
+			if (*p == ',') { p++; continue; }
+			if (*p == ']') { p++; return val; }
+			break;
+		}
 
-		if (s == "false") // bool
-			return new MVJSONValue(key, false);
+		delete val;
+		return NULL;
+	}
+
+	MVJSONValue* MVJSONReader::parseNumber(const string& name, const char*& p, const char* end)
+	{
+		const char* start = p;
+		bool isDouble = false;
+		if ((p != end) && (*p == '-')) p++;
+		while (p != end)
+		{
+			char c = *p;
+			if ((c == '.') || (c == 'e') || (c == 'E') || (c == '+') || (c == '-'))
+				isDouble = true;
+			else if ((c < '0') || (c > '9'))
+				break;
+			p++;
+		}
 
-		if (s == "true")  // bool
-			return new MVJSONValue(key, true);
+		if ((p == start) || ((p - start == 1) && (*start == '-'))) return NULL;
 
-		if (s == "null") // null
-			return new MVJSONValue(key, MVJSON_TYPE_NULL);
+		// the source is a std::string, so strtoll / strtod stop at its terminating zero at worst
+		string source(start, p - start);
+		char* numberEnd;
+		if (isDouble)
+		{
+			double value = strtod(start, &numberEnd);
+			if (numberEnd != p) return NULL;
+			return new MVJSONValue(name, source, value);
+		}
 
-		char first = s[0];
+		long long value = strtoll(start, &numberEnd, 10);
+		if (numberEnd != p) return NULL;
+		return new MVJSONValue(name, source, value);
+	}
 
-		if (first == '"') // string
-			return new MVJSONValue(key, s.substr(1, s.length() - 2));
+	MVJSONValue* MVJSONReader::parseValue(const string& name, const char*& p, const char* end)
+	{
+		skipSpaces(p, end);
+		if (p == end) return NULL;
 
-		if (first == '{') // object
-			return new MVJSONValue(key, parse(s));
+		switch (*p)
+		{
+		case '"': // string
+		{
+			string value;
+			if (!parseString(p, end, value)) return NULL;
+			return new MVJSONValue(name, value);
+		}
 
-		if (first == '[') // array
+		case '{': // object
 		{
-			s.erase(0, 1);
-			s.erase(s.length() - 1, 1);
+			MVJSONNode* node = parseObject(p, end);
+			if (node == NULL) return NULL;
+			return new MVJSONValue(name, node);
+		}
 
-			MVJSONValue* val = new MVJSONValue(key, MVJSON_TYPE_ARRAY);
+		case '[': // array
+			return parseArray(name, p, end);
 
-			if (s != "")
-			{
-				vector<string> parts;
-				splitList(s, parts);
-				for (int i = 0; i < parts.size(); i++)
-					val->arrayValue.push_back(parseValue(parts.at(i), true));
-			}
-			return val;
+		case 't': // bool
+			if (parseLiteral(p, end, "true")) return new MVJSONValue(name, true);
+			return NULL;
+
+		case 'f': // bool
+			if (parseLiteral(p, end, "false")) return new MVJSONValue(name, false);
+			return NULL;
+
+		case 'n': // null
+			if (parseLiteral(p, end, "null")) return new MVJSONValue(name, MVJSON_TYPE_NULL);
+			return NULL;
 		}
 
 		// else its number!
-		if (s.find(".") == string::npos)
-			return new MVJSONValue(key, s, stoll(s));
-		else
-			return new MVJSONValue(key, s, stod(s));
-
-		return NULL;
+		return parseNumber(name, p, end);
 	}
 
 	MVJSONValue::~MVJSONValue()
@@ -189,21 +370,6 @@ namespace JSON {
 		this->name = name;
 
 		stringValue = value;
-
-		// here we switch back special chars
-		//	\"	\\	\/	\b	\f	\n	\r	\t	\u four-hex-digits
-		replace(stringValue, "\\\"", "\"");
-		replace(stringValue, "\\\\", "\\");
-		replace(stringValue, "\\/", "/");
-		replace(stringValue, "\\b", "\b");
-		replace(stringValue, "\\f", "\f");
-		replace(stringValue, "\\n", "\n");
-		replace(stringValue, "\\r", "\r");
-		replace(stringValue, "\\t", "\t");
-
-		// TODO - \u four-hex-digits
-		// SS::replace(stringValue, "\\\\", "\\");
-
 	}
 
 	MVJSONValue::MVJSONValue(const string & name, const string & source, long long value)
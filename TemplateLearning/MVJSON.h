@@ -35,6 +35,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <stdlib.h>
 
 #ifndef MVJSON_H_
@@ -64,9 +65,6 @@ namespace JSON {
 		inline static double stringToDouble(const string& s);										///< convert string to float
 		inline static bool symbolToBeTrimmed(const char& c);										///< check if symbol is space, tab or new line break
 		inline static string trim(const string& text);												///< trim spaces, tabs and line break
-		inline static void replace(string& target, const string& oldStr, const string& newStr);  ///< replace all occurrences of substring
-		inline static void splitInHalf(const string& s, const string& separator, string& begin, string& end);	///< second half (output)
-		inline static void splitList(const string& s, vector<string>& parts);
 	};
 
 
@@ -75,29 +73,32 @@ namespace JSON {
 	/// JSON Value
 	class MVJSONValue : public MVJSONUtils {
 	public:
-		MVJSONValue(string name, MVJSON_TYPE valueType);
-		MVJSONValue(string name, bool value);
-		MVJSONValue(string name, string value);
-		MVJSONValue(string name, int value);
-		MVJSONValue(string name, double value);
-		MVJSONValue(string name, MVJSONNode* value);
+		MVJSONValue(const string& name, MVJSON_TYPE valueType);
+		MVJSONValue(const string& name, bool value);
+		MVJSONValue(const string& name, const string& value);						///< value is already unescaped
+		MVJSONValue(const string& name, const string& source, long long value);	///< source keeps the number as written
+		MVJSONValue(const string& name, const string& source, double value);
+		MVJSONValue(const string& name, MVJSONNode* value);
 		virtual ~MVJSONValue();
 
 		string name;							///< value name [optional]
 		MVJSON_TYPE valueType;					///< type of node
 
-		string stringValue;						///< value if data has string type
+		string stringValue;						///< value if data has string type (source text for numbers)
 		bool boolValue;							///< value if data has bool type
-		int intValue;							///< value if data has int type
+		long long intValue;						///< value if data has int type
 		double doubleValue;						///< value if data has double type
 		MVJSONNode* objValue;					///< value if data has object type
 
 		vector<MVJSONValue*> arrayValue;		///< array of values
 
-		double getFieldDouble(string name);		///< get value of double field of VALUE OBJECT (objValue)
-		int getFieldInt(string name);			///< get value of int field of VALUE OBJECT (objValue)
-		string getFieldString(string name);		///< get value of string field of VALUE OBJECT (objValue)
-		bool getFieldBool(string name);			///< get value of bool field of VALUE OBJECT (objValue)
+		MVJSONValue* field(const string& name);			///< get field of VALUE OBJECT (objValue)
+
+		double getFieldDouble(const string& name);		///< get value of double field of VALUE OBJECT (objValue)
+		int getFieldInt(const string& name);			///< get value of int field of VALUE OBJECT (objValue)
+		long long getFieldLongLong(const string& name);	///< get value of int field of VALUE OBJECT (objValue)
+		string getFieldString(const string& name);		///< get value of string field of VALUE OBJECT (objValue)
+		bool getFieldBool(const string& name);			///< get value of bool field of VALUE OBJECT (objValue)
 
 		inline MVJSONValue* at(unsigned int i) { return arrayValue.at(i); }
 		inline int size() { if (valueType == MVJSON_TYPE_ARRAY) return arrayValue.size(); else return 1; }
@@ -113,28 +114,45 @@ namespace JSON {
 
 		vector<MVJSONValue*> values; 			///< values (props)
 
-		bool hasField(string name);				///< check that object has field
-		MVJSONValue* getField(string name);		///< get field by name
+		bool hasField(const string& name);				///< check that object has field
+		MVJSONValue* getField(const string& name);		///< get field by name
 
-		double getFieldDouble(string name);		///< get value of double field
-		int getFieldInt(string name);			///< get value of int field
-		string getFieldString(string name);		///< get value of string field
-		bool getFieldBool(string name);			///< get value of bool field
+		double getFieldDouble(const string& name);		///< get value of double field
+		int getFieldInt(const string& name);			///< get value of int field
+		long long getFieldLongLong(const string& name);	///< get value of int field
+		string getFieldString(const string& name);		///< get value of string field
+		bool getFieldBool(const string& name);			///< get value of bool field
 	};
 
 	/// Compact JSON parser (based on specification: http://www.json.org/)
+	/// Single forward pass over the source: every character is looked at once and only
+	/// names, strings and number texts are copied out, straight into the tree.
 	class MVJSONReader : public MVJSONUtils {
 	public:
-		MVJSONReader(const string& source);	///< constructor from json source
+		MVJSONReader(const string& source);	///< constructor from json source (top level array is stored as "root" field)
 		virtual ~MVJSONReader();
 
 		MVJSONNode* root;						///< root object (if its null - parsing was failed)
 
 	private:
-		MVJSONValue* parseValue(string text, bool hasNoName);					///< parse value
-		MVJSONNode* parse(string text);											///< parse node
+		// All of them advance p past what they read; nullptr / false means malformed input
+		MVJSONNode* parseObject(const char*& p, const char* end);							///< parse node, p at '{'
+		MVJSONValue* parseValue(const string& name, const char*& p, const char* end);		///< parse value of any type
+		MVJSONValue* parseArray(const string& name, const char*& p, const char* end);		///< parse array, p at '['
+		MVJSONValue* parseNumber(const string& name, const char*& p, const char* end);	///< parse int or double
+		static bool parseString(const char*& p, const char* end, string& result);			///< parse and unescape string, p at '"'
+		static bool parseLiteral(const char*& p, const char* end, const char* literal);	///< match true / false / null
+		static void skipSpaces(const char*& p, const char* end);							///< skip spaces, tabs and line breaks
+	};
 
+	/// Compact JSON writer
+	class MVJSONWriter {
+	public:
+		MVJSONWriter();
 
+		string result;							///< output text
+		int depth;								///< current nesting
+		vector<int> counts;						///< number of values written on each nesting level
 	};
 
 
@@ -178,83 +196,6 @@ namespace JSON {
 		return text.substr(start, end - start + 1);
 	}
 
-	inline void MVJSONUtils::splitInHalf(const string & s,						///< source string to split up
-		const string & separator,				///< separator string)
-		string & begin,						///< first part (output)
-		string & end							///< second half (output)
-	)
-	{
-		int pos = s.find(separator);
-		if (pos == string::npos) { begin = s; end = ""; return; }
-
-		begin = s.substr(0, pos);
-		end = s.substr(pos + separator.length(), s.length() - pos - separator.length());
-	}
-
-	/// split string by "," - ignore content inside of "{", "}", "[", "]" and quotations "...."
-	/// also take \" into account
-	/// (Code should be cleared of comments beforehand)
-	inline void MVJSONUtils::splitList(const string & s,				///< string to be splitted
-		vector<string> & parts			///< result parts
-	)
-	{
-
-		bool isNotInQuotes = true;
-		int b1 = 0;
-		int b2 = 0;
-		int lastPos = 0;
-
-		const char* start = s.c_str();
-		const char* ps = start;
-
-		while (*ps) // *ps != 0
-		{
-			if ((*ps == ',') && (isNotInQuotes) && (b1 == 0) && (b2 == 0))
-			{
-				parts.push_back(s.substr(lastPos, ps - start - lastPos));
-				lastPos = ps - start + 1;
-			}
-
-			if (isNotInQuotes)
-			{
-				if (*ps == '{') b1++;
-				if (*ps == '}') b1--;
-				if (*ps == '[') b2++;
-				if (*ps == ']') b2--;
-			}
-
-			if (*ps == '"')
-			{
-				isNotInQuotes = !isNotInQuotes;
-				if (ps != start)
-					if (*(ps - 1) == '\\')
-						isNotInQuotes = !isNotInQuotes;
-			}
-
-			ps++;
-		}
-
-		parts.push_back(s.substr(lastPos, s.length() - lastPos));
-	}
-
-	inline void MVJSONUtils::replace(string & target,			///< text to be modified
-		const string & oldStr,		///< old string
-		const string & newStr		///< new string
-	)
-	{
-		unsigned int pos = 0;
-		unsigned int oldLen = oldStr.length();
-		unsigned int newLen = newStr.length();
-
-		for (;;)
-		{
-			pos = target.find(oldStr, pos);
-			if (pos == string::npos) break;
-			target.replace(pos, oldLen, newStr);
-			pos += newLen;
-		}
-	}
-
 
 } /* namespace F2 */
 #endif /* MVJSON_H_ */
@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "PoolAllocator/VirtualMemory.h"
+
+// Types whose objects may be moved to another address by copying their bytes
+// and forgetting the old ones. Specialise for types that are not trivially
+// copyable but hold no pointers into themselves (std::unique_ptr, most handles).
+template <class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+// Stateless allocator for large buffers. Requests of at least Threshold bytes
+// get an anonymous mapping of their own, rounded up to whole pages and created
+// with the VirtualMemory flags (HugePages, Sequential, Populate), and are
+// unmapped on deallocate; smaller requests go to std::allocator.
+template <class T, std::size_t Threshold = 1 << 20, unsigned Flags = VirtualMemory::Mapped>
+class MmapAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type is_always_equal;
+
+	template <class U>
+	struct rebind
+	{
+		typedef MmapAllocator<U, Threshold, Flags> other;
+	};
+
+	MmapAllocator() noexcept = default;
+
+	template <class U>
+	MmapAllocator(const MmapAllocator<U, Threshold, Flags>&) noexcept
+	{}
+
+	[[nodiscard]] T* allocate(std::size_t n)
+	{
+		if (n > max_size())
+			throw std::bad_array_new_length();
+		if (!IsMapped(n))
+			return std::allocator<T>().allocate(n);
+
+		void* ptr = VirtualMemory::Map(MappedBytes(n), Flags);
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* p, std::size_t n) noexcept
+	{
+		if (IsMapped(n))
+			VirtualMemory::Unmap(p, MappedBytes(n));
+		else
+			std::allocator<T>().deallocate(p, n);
+	}
+
+	// Moves a buffer of n elements to one of newN, keeping the first used. When
+	// both are mapped the pages are remapped, so a multi-GB buffer grows without
+	// touching its elements; otherwise the bytes are copied. p is invalid afterwards.
+	T* reallocate(T* p, std::size_t n, std::size_t newN, std::size_t used)
+	{
+		static_assert(IsTriviallyRelocatable<T>::value, "reallocate moves elements by their bytes");
+
+		if (IsMapped(n) && IsMapped(newN))
+		{
+			if (MappedBytes(n) == MappedBytes(newN))
+				return p;
+			if (void* moved = VirtualMemory::Remap(p, MappedBytes(n), MappedBytes(newN)))
+				return static_cast<T*>(moved);
+		}
+
+		T* fresh = allocate(newN);
+		std::memcpy(static_cast<void*>(fresh), p, std::min(used, newN) * sizeof(T));
+		deallocate(p, n);
+		return fresh;
+	}
+
+	std::size_t max_size() const noexcept
+	{
+		return std::numeric_limits<std::size_t>::max() / 2 / sizeof(T);
+	}
+
+	static bool IsMapped(std::size_t n) { return n * sizeof(T) >= Threshold; }
+
+	static std::size_t MappedBytes(std::size_t n)
+	{
+		const std::size_t pageSize = VirtualMemory::PageSize();
+		return (n * sizeof(T) + pageSize - 1) / pageSize * pageSize;
+	}
+
+	// Elements that fit into what a request for n really gets (the page tail of a mapping)
+	static std::size_t Capacity(std::size_t n) { return IsMapped(n) ? MappedBytes(n) / sizeof(T) : n; }
+};
+
+template <class T, class U, std::size_t Threshold, unsigned Flags>
+bool operator==(const MmapAllocator<T, Threshold, Flags>&, const MmapAllocator<U, Threshold, Flags>&) { return true; }
+template <class T, class U, std::size_t Threshold, unsigned Flags>
+bool operator!=(const MmapAllocator<T, Threshold, Flags>&, const MmapAllocator<U, Threshold, Flags>&) { return false; }
+
+// Growable array on MmapAllocator. Trivially relocatable elements grow through
+// MmapAllocator::reallocate (mremap once the buffer is mapped), anything else
+// is moved element by element like std::vector does.
+template <class T, std::size_t Threshold = 1 << 20, unsigned Flags = VirtualMemory::Mapped>
+class MmapVector
+{
+	typedef MmapAllocator<T, Threshold, Flags> Allocator;
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	MmapVector() = default;
+
+	explicit MmapVector(size_type count)
+	{
+		resize(count);
+	}
+
+	MmapVector(const MmapVector&) = delete;
+	MmapVector& operator=(const MmapVector&) = delete;
+
+	MmapVector(MmapVector&& other) noexcept
+		: m_Data(std::exchange(other.m_Data, nullptr))
+		, m_Size(std::exchange(other.m_Size, 0))
+		, m_Capacity(std::exchange(other.m_Capacity, 0))
+	{}
+
+	MmapVector& operator=(MmapVector&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			m_Data = std::exchange(other.m_Data, nullptr);
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Capacity = std::exchange(other.m_Capacity, 0);
+		}
+		return *this;
+	}
+
+	~MmapVector()
+	{
+		Release();
+	}
+
+	void reserve(size_type count)
+	{
+		if (count > m_Capacity)
+			Reallocate(count);
+	}
+
+	void resize(size_type count)
+	{
+		reserve(count);
+		if (count > m_Size)
+			std::uninitialized_value_construct(m_Data + m_Size, m_Data + count);
+		else
+			std::destroy(m_Data + count, m_Data + m_Size);
+		m_Size = count;
+	}
+
+	template <class... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (m_Size == m_Capacity)
+		{
+			// args may refer into the buffer that is about to move
+			T value(std::forward<Args>(args)...);
+			Reallocate(m_Capacity == 0 ? 16 : m_Capacity * 2);
+			return *::new (static_cast<void*>(m_Data + m_Size++)) T(std::move(value));
+		}
+		return *::new (static_cast<void*>(m_Data + m_Size++)) T(std::forward<Args>(args)...);
+	}
+
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	void pop_back()
+	{
+		std::destroy_at(m_Data + --m_Size);
+	}
+
+	void clear()
+	{
+		std::destroy(m_Data, m_Data + m_Size);
+		m_Size = 0;
+	}
+
+	T& operator[](size_type index) { return m_Data[index]; }
+	const T& operator[](size_type index) const { return m_Data[index]; }
+
+	T& back() { return m_Data[m_Size - 1]; }
+
+	T* data() { return m_Data; }
+	const T* data() const { return m_Data; }
+
+	iterator begin() { return m_Data; }
+	iterator end() { return m_Data + m_Size; }
+	const_iterator begin() const { return m_Data; }
+	const_iterator end() const { return m_Data + m_Size; }
+
+	size_type size() const { return m_Size; }
+	size_type capacity() const { return m_Capacity; }
+	bool empty() const { return m_Size == 0; }
+
+private:
+	void Reallocate(size_type count)
+	{
+		Allocator allocator;
+		const size_type capacity = Allocator::Capacity(count);
+
+		if constexpr (IsTriviallyRelocatable<T>::value)
+		{
+			m_Data = m_Data != nullptr ? allocator.reallocate(m_Data, m_Capacity, capacity, m_Size) : allocator.allocate(capacity);
+		}
+		else
+		{
+			T* fresh = allocator.allocate(capacity);
+			try
+			{
+				std::uninitialized_move(m_Data, m_Data + m_Size, fresh);
+			}
+			catch (...)
+			{
+				allocator.deallocate(fresh, capacity);
+				throw;
+			}
+			Release();
+			m_Data = fresh;
+		}
+		m_Capacity = capacity;
+	}
+
+	// Destroys the elements and frees the buffer; m_Size is left to the caller
+	void Release()
+	{
+		if (m_Data == nullptr)
+			return;
+		std::destroy(m_Data, m_Data + m_Size);
+		Allocator().deallocate(m_Data, m_Capacity);
+		m_Data = nullptr;
+	}
+
+	T* m_Data = nullptr;
+	size_type m_Size = 0;
+	size_type m_Capacity = 0;
+};
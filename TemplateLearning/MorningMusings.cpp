@@ -1,4 +1,17 @@
-#include "includes.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #define ALLOCATOR_TRAITS(T)                \
 typedef T                 type;            \
@@ -100,6 +113,683 @@ public:
 	size_type max_size(void) const { return max_allocations<T>::value; }
 };
 
+// Policies below return a null pointer when they cannot serve a request, so
+// they can be chained; allocator turns a final null into std::bad_alloc.
+// Stateful policies keep their state behind a shared_ptr that every copy and
+// every rebind shares, so the node allocator a container rebinds to draws from
+// the same memory as the allocator it was given.
+
+// Fixed-size chunks carved from blocks, one free list per chunk size. Shared by
+// all rebinds of a pool, so pool<T> and pool<Node> are interchangeable. The
+// size classes (multiples of max_align_t up to 1/16 of a block) are created up
+// front, so looking one up never writes.
+class pool_family
+{
+	static constexpr std::size_t Granularity = alignof(std::max_align_t);
+
+public:
+	explicit pool_family(std::size_t blockBytes)
+		: m_BlockBytes(blockBytes)
+		, m_Classes(blockBytes / 16 / Granularity)
+	{
+		for (std::size_t i = 0; i < m_Classes.size(); ++i)
+		{
+			m_Classes[i].chunkSize = (i + 1) * Granularity;
+		}
+	}
+
+	~pool_family()
+	{
+		for (auto const& block : m_Blocks)
+		{
+			::operator delete(block.first);
+		}
+	}
+
+	pool_family(pool_family const&) = delete;
+	pool_family& operator=(pool_family const&) = delete;
+
+	struct size_class
+	{
+		std::size_t chunkSize;
+		void* freeList = nullptr;
+		char* bump = nullptr;
+		char* bumpEnd = nullptr;
+	};
+
+	// Null for sizes above the largest class
+	size_class* find_class(std::size_t size)
+	{
+		const std::size_t index = (std::max(size, sizeof(void*)) + Granularity - 1) / Granularity - 1;
+		return index < m_Classes.size() ? &m_Classes[index] : nullptr;
+	}
+
+	void* allocate(size_class& sizeClass)
+	{
+		if (sizeClass.freeList != nullptr)
+		{
+			void* chunk = sizeClass.freeList;
+			sizeClass.freeList = *static_cast<void**>(chunk);
+			return chunk;
+		}
+		if (sizeClass.bump == sizeClass.bumpEnd)
+		{
+			const std::size_t bytes = std::max(m_BlockBytes, sizeClass.chunkSize) / sizeClass.chunkSize * sizeClass.chunkSize;
+			char* block = static_cast<char*>(::operator new(bytes, std::nothrow));
+			if (block == nullptr)
+			{
+				return nullptr;
+			}
+			const std::pair<char*, char*> range(block, block + bytes);
+			m_Blocks.insert(std::upper_bound(m_Blocks.begin(), m_Blocks.end(), range), range);
+			sizeClass.bump = block;
+			sizeClass.bumpEnd = block + bytes;
+		}
+		void* chunk = sizeClass.bump;
+		sizeClass.bump += sizeClass.chunkSize;
+		return chunk;
+	}
+
+	void deallocate(size_class& sizeClass, void* chunk)
+	{
+		*static_cast<void**>(chunk) = sizeClass.freeList;
+		sizeClass.freeList = chunk;
+	}
+
+	bool owns(void const* ptr) const
+	{
+		char const* address = static_cast<char const*>(ptr);
+		auto it = std::upper_bound(m_Blocks.begin(), m_Blocks.end(), address,
+			[](char const* value, std::pair<char*, char*> const& block) { return value < block.first; });
+		return it != m_Blocks.begin() && address < (--it)->second;
+	}
+
+private:
+	std::size_t m_BlockBytes;
+	std::vector<size_class> m_Classes;
+	// [start, end) of every block, sorted for owns()
+	std::vector<std::pair<char*, char*>> m_Blocks;
+};
+
+// Objects and small arrays (up to 1/16 of a block) from a pool_family, single
+// objects through a size class looked up once; larger requests return null
+template <typename T, std::size_t BlockBytes = 64 * 1024>
+class pool
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef pool<U, BlockBytes> other;
+	};
+
+	// Default Constructor
+	pool(void)
+		: m_Family(std::make_shared<pool_family>(BlockBytes))
+		, m_Class(m_Family->find_class(sizeof(T)))
+	{
+	}
+
+	// Copy Constructor
+	template <typename U>
+	pool(pool<U, BlockBytes> const& other)
+		: m_Family(other.family())
+		, m_Class(m_Family->find_class(sizeof(T)))
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer /* hint */ = 0)
+	{
+		pool_family::size_class* sizeClass = count == 1 ? m_Class : count <= max_size() ? m_Family->find_class(count * sizeof(type)) : 0;
+		return sizeClass != 0 ? static_cast<pointer>(m_Family->allocate(*sizeClass)) : 0;
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		m_Family->deallocate(count == 1 ? *m_Class : *m_Family->find_class(count * sizeof(type)), ptr);
+	}
+
+	bool owns(const_pointer ptr) const { return m_Family->owns(ptr); }
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return BlockBytes / 16 / sizeof(T); }
+
+	std::shared_ptr<pool_family> const& family(void) const { return m_Family; }
+
+private:
+	std::shared_ptr<pool_family> m_Family;
+	pool_family::size_class* m_Class;
+};
+
+// One buffer handed out by bumping a pointer; freeing the newest allocation
+// rewinds it, anything else is reclaimed with the arena
+class arena_buffer
+{
+public:
+	explicit arena_buffer(std::size_t bytes)
+		: m_Begin(static_cast<char*>(::operator new(bytes)))
+		, m_Current(m_Begin)
+		, m_End(m_Begin + bytes)
+	{
+	}
+
+	~arena_buffer()
+	{
+		::operator delete(m_Begin);
+	}
+
+	arena_buffer(arena_buffer const&) = delete;
+	arena_buffer& operator=(arena_buffer const&) = delete;
+
+	void* allocate(std::size_t bytes, std::size_t alignment)
+	{
+		void* ptr = m_Current;
+		std::size_t space = static_cast<std::size_t>(m_End - m_Current);
+		if (std::align(alignment, bytes, ptr, space) == nullptr)
+		{
+			return nullptr;
+		}
+		m_Current = static_cast<char*>(ptr) + bytes;
+		return ptr;
+	}
+
+	void deallocate(void* ptr, std::size_t bytes)
+	{
+		if (static_cast<char*>(ptr) + bytes == m_Current)
+		{
+			m_Current = static_cast<char*>(ptr);
+		}
+	}
+
+	bool owns(void const* ptr) const
+	{
+		return ptr >= m_Begin && ptr < m_End;
+	}
+
+	std::size_t used(void) const { return static_cast<std::size_t>(m_Current - m_Begin); }
+
+private:
+	char* m_Begin;
+	char* m_Current;
+	char* m_End;
+};
+
+// Stack/arena policy; every rebind shares the buffer
+template <typename T, std::size_t Bytes = 64 * 1024>
+class arena
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef arena<U, Bytes> other;
+	};
+
+	// Default Constructor
+	arena(void)
+		: m_Buffer(std::make_shared<arena_buffer>(Bytes))
+	{
+	}
+
+	// Copy Constructor
+	template <typename U>
+	arena(arena<U, Bytes> const& other)
+		: m_Buffer(other.buffer())
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer /* hint */ = 0)
+	{
+		if (count > max_size()) { return 0; }
+		return static_cast<pointer>(m_Buffer->allocate(count * sizeof(type), alignof(type)));
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		m_Buffer->deallocate(ptr, count * sizeof(type));
+	}
+
+	bool owns(const_pointer ptr) const { return m_Buffer->owns(ptr); }
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return Bytes / sizeof(T); }
+
+	std::shared_ptr<arena_buffer> const& buffer(void) const { return m_Buffer; }
+
+private:
+	std::shared_ptr<arena_buffer> m_Buffer;
+};
+
+// Tries Primary first and falls back to Secondary when it returns null;
+// Primary must be able to tell its own pointers (owns)
+template <typename T, typename Primary, typename Secondary>
+class fallback
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef fallback<U, typename Primary::template rebind<U>::other, typename Secondary::template rebind<U>::other> other;
+	};
+
+	// Default Constructor
+	fallback(void)
+	{
+	}
+
+	fallback(Primary const& primary, Secondary const& secondary)
+		: m_Primary(primary)
+		, m_Secondary(secondary)
+	{
+	}
+
+	// Copy Constructor
+	template <typename U, typename PrimaryU, typename SecondaryU>
+	fallback(fallback<U, PrimaryU, SecondaryU> const& other)
+		: m_Primary(other.primary())
+		, m_Secondary(other.secondary())
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		pointer ptr = m_Primary.allocate(count, hint);
+		return ptr != 0 ? ptr : m_Secondary.allocate(count, hint);
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		if (m_Primary.owns(ptr))
+		{
+			m_Primary.deallocate(ptr, count);
+		}
+		else
+		{
+			m_Secondary.deallocate(ptr, count);
+		}
+	}
+
+	bool owns(const_pointer ptr) const { return m_Primary.owns(ptr) || m_Secondary.owns(ptr); }
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return std::max(m_Primary.max_size(), m_Secondary.max_size()); }
+
+	Primary const& primary(void) const { return m_Primary; }
+	Secondary const& secondary(void) const { return m_Secondary; }
+
+private:
+	Primary m_Primary;
+	Secondary m_Secondary;
+};
+
+// Requests of up to ThresholdBytes go to Small, larger ones to Large
+template <typename T, std::size_t ThresholdBytes, typename Small, typename Large>
+class segregator
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef segregator<U, ThresholdBytes, typename Small::template rebind<U>::other, typename Large::template rebind<U>::other> other;
+	};
+
+	// Default Constructor
+	segregator(void)
+	{
+	}
+
+	segregator(Small const& small, Large const& large)
+		: m_Small(small)
+		, m_Large(large)
+	{
+	}
+
+	// Copy Constructor
+	template <typename U, typename SmallU, typename LargeU>
+	segregator(segregator<U, ThresholdBytes, SmallU, LargeU> const& other)
+		: m_Small(other.small())
+		, m_Large(other.large())
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		return is_small(count) ? m_Small.allocate(count, hint) : m_Large.allocate(count, hint);
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		if (is_small(count))
+		{
+			m_Small.deallocate(ptr, count);
+		}
+		else
+		{
+			m_Large.deallocate(ptr, count);
+		}
+	}
+
+	bool owns(const_pointer ptr) const { return m_Small.owns(ptr) || m_Large.owns(ptr); }
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return m_Large.max_size(); }
+
+	Small const& small(void) const { return m_Small; }
+	Large const& large(void) const { return m_Large; }
+
+private:
+	static bool is_small(size_type count) { return count * sizeof(T) <= ThresholdBytes; }
+
+	Small m_Small;
+	Large m_Large;
+};
+
+// Counts what passes through Policy; the counters are shared by every copy and
+// rebind, so the allocator handed to a container reports for the container
+struct allocation_stats
+{
+	std::atomic<std::size_t> allocations{ 0 };
+	std::atomic<std::size_t> deallocations{ 0 };
+	std::atomic<std::size_t> failures{ 0 };
+	std::atomic<std::size_t> bytesInUse{ 0 };
+	std::atomic<std::size_t> peakBytes{ 0 };
+};
+
+template <typename T, typename Policy>
+class stats
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef stats<U, typename Policy::template rebind<U>::other> other;
+	};
+
+	// Default Constructor
+	stats(void)
+		: m_Stats(std::make_shared<allocation_stats>())
+	{
+	}
+
+	explicit stats(Policy const& policy)
+		: m_Policy(policy)
+		, m_Stats(std::make_shared<allocation_stats>())
+	{
+	}
+
+	// Copy Constructor
+	template <typename U, typename PolicyU>
+	stats(stats<U, PolicyU> const& other)
+		: m_Policy(other.policy())
+		, m_Stats(other.counters())
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		pointer ptr = m_Policy.allocate(count, hint);
+		if (ptr == 0)
+		{
+			m_Stats->failures.fetch_add(1, std::memory_order_relaxed);
+			return 0;
+		}
+		m_Stats->allocations.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t inUse = m_Stats->bytesInUse.fetch_add(count * sizeof(type), std::memory_order_relaxed) + count * sizeof(type);
+		std::size_t peak = m_Stats->peakBytes.load(std::memory_order_relaxed);
+		while (inUse > peak && !m_Stats->peakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+		{
+		}
+		return ptr;
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		m_Stats->deallocations.fetch_add(1, std::memory_order_relaxed);
+		m_Stats->bytesInUse.fetch_sub(count * sizeof(type), std::memory_order_relaxed);
+		m_Policy.deallocate(ptr, count);
+	}
+
+	bool owns(const_pointer ptr) const { return m_Policy.owns(ptr); }
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return m_Policy.max_size(); }
+
+	std::size_t allocations(void) const { return m_Stats->allocations.load(std::memory_order_relaxed); }
+	std::size_t deallocations(void) const { return m_Stats->deallocations.load(std::memory_order_relaxed); }
+	std::size_t failures(void) const { return m_Stats->failures.load(std::memory_order_relaxed); }
+	std::size_t bytes_in_use(void) const { return m_Stats->bytesInUse.load(std::memory_order_relaxed); }
+	std::size_t peak_bytes(void) const { return m_Stats->peakBytes.load(std::memory_order_relaxed); }
+
+	Policy const& policy(void) const { return m_Policy; }
+	std::shared_ptr<allocation_stats> const& counters(void) const { return m_Stats; }
+
+private:
+	Policy m_Policy;
+	std::shared_ptr<allocation_stats> m_Stats;
+};
+
+// Mutex of one thread_cache family; id tells the families apart in the thread caches
+struct thread_cache_lock
+{
+	std::mutex mutex;
+	std::uint64_t id;
+
+	thread_cache_lock(void)
+	{
+		static std::atomic<std::uint64_t> nextId{ 1 };
+		id = nextId.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+// Makes Policy usable from many threads: a mutex shared by every copy and
+// rebind guards it, and each thread keeps up to CacheSize freed single objects
+// that it hands out again without taking the lock. A thread's cache serves one
+// allocator family at a time and holds a copy of its policy, so the memory it
+// caches stays valid until the cache moves on or the thread exits.
+template <typename T, typename Policy, std::size_t CacheSize = 64>
+class thread_cache
+{
+public:
+
+	ALLOCATOR_TRAITS(T)
+
+	template <typename U>
+	struct rebind
+	{
+		typedef thread_cache<U, typename Policy::template rebind<U>::other, CacheSize> other;
+	};
+
+	// Default Constructor
+	thread_cache(void)
+		: m_Lock(std::make_shared<thread_cache_lock>())
+	{
+	}
+
+	explicit thread_cache(Policy const& policy)
+		: m_Policy(policy)
+		, m_Lock(std::make_shared<thread_cache_lock>())
+	{
+	}
+
+	// Copy Constructor
+	template <typename U, typename PolicyU>
+	thread_cache(thread_cache<U, PolicyU, CacheSize> const& other)
+		: m_Policy(other.policy())
+		, m_Lock(other.lock())
+	{
+	}
+
+	// Allocate memory
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		if (count == 1)
+		{
+			cache& local = thread_local_cache();
+			if (local.id == m_Lock->id && local.count != 0)
+			{
+				return local.items[--local.count];
+			}
+		}
+		std::lock_guard<std::mutex> guard(m_Lock->mutex);
+		return m_Policy.allocate(count, hint);
+	}
+
+	// Delete memory
+	void deallocate(pointer ptr, size_type count)
+	{
+		if (count == 1)
+		{
+			cache& local = thread_local_cache();
+			if (local.id != m_Lock->id)
+			{
+				local.adopt(m_Policy, m_Lock);
+			}
+			if (local.count == CacheSize)
+			{
+				local.flush(CacheSize / 2);
+			}
+			local.items[local.count++] = ptr;
+			return;
+		}
+		std::lock_guard<std::mutex> guard(m_Lock->mutex);
+		m_Policy.deallocate(ptr, count);
+	}
+
+	bool owns(const_pointer ptr) const
+	{
+		std::lock_guard<std::mutex> guard(m_Lock->mutex);
+		return m_Policy.owns(ptr);
+	}
+
+	// Max number of objects that can be allocated in one call
+	size_type max_size(void) const { return m_Policy.max_size(); }
+
+	Policy const& policy(void) const { return m_Policy; }
+	std::shared_ptr<thread_cache_lock> const& lock(void) const { return m_Lock; }
+
+private:
+	struct cache
+	{
+		std::uint64_t id = 0;
+		std::shared_ptr<thread_cache_lock> lock;
+		std::optional<Policy> policy;
+		pointer items[CacheSize];
+		std::size_t count = 0;
+
+		~cache()
+		{
+			flush(count);
+		}
+
+		// Returns the newest count items to the policy they came from
+		void flush(std::size_t items_to_return)
+		{
+			if (items_to_return == 0)
+			{
+				return;
+			}
+			std::lock_guard<std::mutex> guard(lock->mutex);
+			for (std::size_t i = 0; i < items_to_return; ++i)
+			{
+				policy->deallocate(items[--count], 1);
+			}
+		}
+
+		void adopt(Policy const& newPolicy, std::shared_ptr<thread_cache_lock> const& newLock)
+		{
+			flush(count);
+			policy.emplace(newPolicy);
+			lock = newLock;
+			id = newLock->id;
+		}
+	};
+
+	static cache& thread_local_cache(void)
+	{
+		static thread_local cache local;
+		return local;
+	}
+
+	Policy m_Policy;
+	std::shared_ptr<thread_cache_lock> m_Lock;
+};
+
+// Whether two policies can free each other's memory; unrelated policies cannot
+template <typename PolicyT, typename PolicyU>
+bool policies_equal(PolicyT const&, PolicyU const&)
+{
+	return false;
+}
+
+template <typename T, typename U>
+bool policies_equal(heap<T> const&, heap<U> const&)
+{
+	return true;
+}
+
+template <typename T, typename U, std::size_t BlockBytes>
+bool policies_equal(pool<T, BlockBytes> const& left, pool<U, BlockBytes> const& right)
+{
+	return left.family() == right.family();
+}
+
+template <typename T, typename U, std::size_t Bytes>
+bool policies_equal(arena<T, Bytes> const& left, arena<U, Bytes> const& right)
+{
+	return left.buffer() == right.buffer();
+}
+
+template <typename T, typename PrimaryT, typename SecondaryT,
+          typename U, typename PrimaryU, typename SecondaryU>
+bool policies_equal(fallback<T, PrimaryT, SecondaryT> const& left, fallback<U, PrimaryU, SecondaryU> const& right)
+{
+	return policies_equal(left.primary(), right.primary()) && policies_equal(left.secondary(), right.secondary());
+}
+
+template <typename T, std::size_t ThresholdBytes, typename SmallT, typename LargeT,
+          typename U, typename SmallU, typename LargeU>
+bool policies_equal(segregator<T, ThresholdBytes, SmallT, LargeT> const& left, segregator<U, ThresholdBytes, SmallU, LargeU> const& right)
+{
+	return policies_equal(left.small(), right.small()) && policies_equal(left.large(), right.large());
+}
+
+template <typename T, typename PolicyT, typename U, typename PolicyU>
+bool policies_equal(stats<T, PolicyT> const& left, stats<U, PolicyU> const& right)
+{
+	return left.counters() == right.counters() && policies_equal(left.policy(), right.policy());
+}
+
+template <typename T, typename PolicyT, typename U, typename PolicyU, std::size_t CacheSize>
+bool policies_equal(thread_cache<T, PolicyT, CacheSize> const& left, thread_cache<U, PolicyU, CacheSize> const& right)
+{
+	return left.lock() == right.lock() && policies_equal(left.policy(), right.policy());
+}
+
 #define FORWARD_ALLOCATOR_TRAITS(C)                  \
 typedef typename C::value_type      value_type;      \
 typedef typename C::pointer         pointer;         \
@@ -119,6 +809,12 @@ public:
 
 	FORWARD_ALLOCATOR_TRAITS(Policy)
 
+	// Stateful policies compare unequal across instances, so the policy follows the
+	// elements on assignment and swap; otherwise they are freed into the wrong pool
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
 	template <typename U>
 	struct rebind
 	{
@@ -131,6 +827,12 @@ public:
 	{
 	}
 
+	// Constructor from a configured policy (arena size, shared pool, ...)
+	explicit allocator(Policy const& policy)
+		: Policy(policy)
+	{
+	}
+
 	// Copy Constructor
 	template <typename U,
 	          typename PolicyU,
@@ -139,16 +841,24 @@ public:
 		: Policy(other)
 		, Traits(other)
 	{}
+
+	// Allocate memory; the policy chain returns null when nothing could serve it
+	pointer allocate(size_type count, const_pointer hint = 0)
+	{
+		pointer ptr = Policy::allocate(count, hint);
+		if (ptr == 0) { throw std::bad_alloc(); }
+		return ptr;
+	}
 };
 
 
-// Two allocators are not equal unless a specialization says so
+// Two allocators are equal when their policies can free each other's memory
 template <typename T, typename PolicyT, typename TraitsT,
           typename U, typename PolicyU, typename TraitsU>
 bool operator==(allocator<T, PolicyT, TraitsT> const& left,
                 allocator<U, PolicyU, TraitsU> const& right)
 {
-	return false;
+	return policies_equal(static_cast<PolicyT const&>(left), static_cast<PolicyU const&>(right));
 }
 
 // Also implement inequality
@@ -178,24 +888,6 @@ bool operator!=(allocator<T, PolicyT, TraitsT> const& left,
 	return !(left == right);
 }
 
-// Specialize for the heap policy
-template <typename T, typename TraitsT,
-          typename U, typename TraitsU>
-bool operator==(allocator<T, heap<T>, TraitsT> const& left,
-                allocator<U, heap<U>, TraitsU> const& right)
-{
-	return true;
-}
-
-// Also implement inequality
-template <typename T, typename TraitsT,
-          typename U, typename TraitsU>
-bool operator!=(allocator<T, heap<T>, TraitsT> const& left,
-                allocator<U, heap<U>, TraitsU> const& right)
-{
-	return !(left == right);
-}
-
 #include <set>
 
 struct Example
@@ -213,6 +905,30 @@ struct Example
 	}
 };
 
+// Builds and tears down a set (nodes) and a vector (arrays) with one allocator
+template <typename Alloc>
+void time_containers(char const* name, Alloc const& alloc)
+{
+	using node_alloc = typename Alloc::template rebind<int>::other;
+	const auto before = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < 10; ++round)
+	{
+		std::set<int, std::less<int>, node_alloc> values{ node_alloc(alloc) };
+		std::vector<int, node_alloc> order{ node_alloc(alloc) };
+		for (int i = 0; i < 20000; ++i)
+		{
+			values.insert((i * 7919) % 20000);
+			order.push_back(i);
+		}
+		for (int i = 0; i < 20000; i += 2)
+		{
+			values.erase(i);
+		}
+	}
+	const auto after = std::chrono::high_resolution_clock::now();
+	std::cout << name << ": " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << " us" << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
 	// Increase scope
@@ -225,4 +941,36 @@ int main(int argc, char* argv[])
 		foo.insert(Example(2));
 	}
 	// Leaving scope
+
+	// Same building blocks, tuned per use
+	typedef segregator<int, 256, pool<int>, heap<int>> small_pool;
+	typedef fallback<int, arena<int, 1024 * 1024>, heap<int>> arena_first;
+
+	time_containers("heap", allocator<int, heap<int>>());
+	time_containers("pool <= 256 B, heap above", allocator<int, small_pool>());
+	time_containers("1 MB arena, heap when full", allocator<int, arena_first>());
+
+	allocator<int, stats<int, small_pool>> counted;
+	time_containers("stats(pool <= 256 B, heap above)", counted);
+	std::cout << "  allocations " << counted.allocations() << ", peak " << counted.peak_bytes() << " bytes, in use " << counted.bytes_in_use() << std::endl;
+
+	// One pool shared by four threads; frees and reallocations mostly stay in the thread's cache
+	allocator<int, segregator<int, 256, thread_cache<int, pool<int>>, heap<int>>> shared;
+	const auto before = std::chrono::high_resolution_clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 4; ++t)
+	{
+		workers.emplace_back([&shared] { time_containers("  thread_cache(pool) worker", shared); });
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	const auto after = std::chrono::high_resolution_clock::now();
+	std::cout << "thread_cache(pool), 4 threads: " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << " us" << std::endl;
+
+	// Copies and rebinds share state, so they compare equal; separate pools do not
+	allocator<int, pool<int>> first;
+	allocator<double, pool<double>> rebound(first);
+	std::cout << std::boolalpha << (first == rebound) << ' ' << (first == allocator<int, pool<int>>()) << std::endl;
 }
@@ -1,12 +1,34 @@
 #ifndef AllocatorH
 #define AllocatorH
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <new>
+#include <typeindex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 constexpr int GROW_SIZE = 1024;
+// Arrays up to this many bytes come from per-element-count pools, larger ones from the system
+constexpr std::size_t MAX_POOLED_ARRAY_BYTES = 4096;
 
 namespace Moya
 {
+	// Automatic trimming of a MemoryPool. Every checkInterval deallocations the pool compares
+	// its live blocks with the blocks it reserves; after sustainedChecks checks in a row below
+	// lowUsage it trims itself down to keepBytes. checkInterval == 0 turns it off.
+	struct TrimPolicy
+	{
+		std::size_t checkInterval = 0;
+		std::size_t sustainedChecks = 8;
+		double lowUsage = 0.25;
+		std::size_t keepBytes = 0;
+	};
+
 	template <class T, std::size_t growSize = GROW_SIZE>
 	class MemoryPool
 	{
@@ -18,11 +40,11 @@ namespace Moya
 		class Buffer
 		{
 			static const std::size_t blockSize = sizeof(T) > sizeof(Block) ? sizeof(T) : sizeof(Block);
-			uint8_t data[blockSize * growSize];
+			alignas(alignof(T) > alignof(Block) ? alignof(T) : alignof(Block)) uint8_t data[blockSize * growSize];
 
 		public:
 
-			Buffer* const next;
+			Buffer* next;
 
 			explicit Buffer(Buffer* next)
 				: data{}
@@ -34,11 +56,31 @@ namespace Moya
 			{
 				return reinterpret_cast<T*>(&data[blockSize * index]);
 			}
+
+			const uint8_t* begin() const
+			{
+				return data;
+			}
+		};
+
+		// One Buffer as seen by trim(), ordered by address to find the owner of a free block
+		struct BufferUsage
+		{
+			const uint8_t* start;
+			Buffer* buffer;
+			std::size_t freeBlocks;
+			bool release;
 		};
 
 		Block* firstFreeBlock = nullptr;
 		Buffer* firstBuffer = nullptr;
 		std::size_t bufferedBlocks = growSize;
+		std::size_t bufferCount = 0;
+		std::size_t liveBlocks = 0;
+
+		TrimPolicy trimPolicy;
+		std::size_t sinceTrimCheck = 0;
+		std::size_t lowUsageChecks = 0;
 
 
 	public:
@@ -60,6 +102,7 @@ namespace Moya
 
 		T* allocate()
 		{
+			++liveBlocks;
 			if (firstFreeBlock)
 			{
 				Block* block = firstFreeBlock;
@@ -71,6 +114,7 @@ namespace Moya
 			{
 				firstBuffer = new Buffer(firstBuffer);
 				bufferedBlocks = 0;
+				++bufferCount;
 			}
 
 			return firstBuffer->getBlock(bufferedBlocks++);
@@ -81,12 +125,228 @@ namespace Moya
 			auto block = reinterpret_cast<Block*>(pointer);
 			block->next = firstFreeBlock;
 			firstFreeBlock = block;
+
+			--liveBlocks;
+			if (trimPolicy.checkInterval && ++sinceTrimCheck >= trimPolicy.checkInterval)
+				checkTrim();
+		}
+
+		// Returns every completely free Buffer to the system, returns the bytes released
+		std::size_t shrink()
+		{
+			return trim(0);
+		}
+
+		// Returns completely free Buffers until at most keepBytes stay reserved. Live blocks
+		// never move, so a Buffer holding a single live block stays. Returns the bytes released.
+		std::size_t trim(const std::size_t keepBytes)
+		{
+			const std::size_t reserved = reservedBytes();
+			if (reserved <= keepBytes)
+				return 0;
+
+			std::vector<BufferUsage> usage = bufferUsage();
+			std::size_t released = 0;
+			for (auto& entry : usage)
+			{
+				if (reserved - released <= keepBytes)
+					break;
+				if (entry.freeBlocks == growSize)
+				{
+					entry.release = true;
+					released += sizeof(Buffer);
+				}
+			}
+			if (!released)
+				return 0;
+
+			// Unhook the free blocks of released Buffers before the memory goes away
+			Block** link = &firstFreeBlock;
+			while (*link)
+			{
+				if (findUsage(usage, *link).release)
+					*link = (*link)->next;
+				else
+					link = &(*link)->next;
+			}
+
+			// Only the newest Buffer is partly untouched; once it is gone every remaining one is fully carved
+			if (findUsage(usage, firstBuffer->begin()).release)
+				bufferedBlocks = growSize;
+
+			Buffer** bufferLink = &firstBuffer;
+			while (*bufferLink)
+			{
+				Buffer* buffer = *bufferLink;
+				if (findUsage(usage, buffer->begin()).release)
+				{
+					*bufferLink = buffer->next;
+					delete buffer;
+					--bufferCount;
+				}
+				else
+					bufferLink = &buffer->next;
+			}
+			return released;
+		}
+
+		void setTrimPolicy(const TrimPolicy& policy)
+		{
+			trimPolicy = policy;
+			sinceTrimCheck = 0;
+			lowUsageChecks = 0;
+		}
+
+		std::size_t liveCount() const
+		{
+			return liveBlocks;
+		}
+
+		// Live blocks of every Buffer, newest Buffer first; walks the free list
+		std::vector<std::size_t> bufferLiveCounts() const
+		{
+			const std::vector<BufferUsage> usage = bufferUsage();
+			std::vector<std::size_t> liveCounts;
+			liveCounts.reserve(bufferCount);
+			for (const Buffer* buffer = firstBuffer; buffer; buffer = buffer->next)
+				liveCounts.push_back(growSize - findUsage(usage, buffer->begin()).freeBlocks);
+			return liveCounts;
+		}
+
+		std::size_t reservedBlocks() const
+		{
+			return bufferCount * growSize;
+		}
+
+		std::size_t reservedBytes() const
+		{
+			return bufferCount * sizeof(Buffer);
+		}
+
+	private:
+		// Free blocks per Buffer: the free list plus the untouched tail of the newest Buffer.
+		// Computed on demand so allocate/deallocate never have to find a block's Buffer.
+		std::vector<BufferUsage> bufferUsage() const
+		{
+			std::vector<BufferUsage> usage;
+			usage.reserve(bufferCount);
+			for (Buffer* buffer = firstBuffer; buffer; buffer = buffer->next)
+				usage.push_back({ buffer->begin(), buffer, buffer == firstBuffer ? growSize - bufferedBlocks : 0, false });
+			std::sort(usage.begin(), usage.end(), [](const BufferUsage& lhs, const BufferUsage& rhs) { return lhs.start < rhs.start; });
+
+			for (const Block* block = firstFreeBlock; block; block = block->next)
+				++findUsage(usage, block).freeBlocks;
+			return usage;
+		}
+
+		static BufferUsage& findUsage(std::vector<BufferUsage>& usage, const void* pointer)
+		{
+			auto it = std::upper_bound(usage.begin(), usage.end(), static_cast<const uint8_t*>(pointer),
+				[](const uint8_t* address, const BufferUsage& entry) { return address < entry.start; });
+			return *--it;
+		}
+
+		static const BufferUsage& findUsage(const std::vector<BufferUsage>& usage, const void* pointer)
+		{
+			return findUsage(const_cast<std::vector<BufferUsage>&>(usage), pointer);
+		}
+
+		void checkTrim()
+		{
+			sinceTrimCheck = 0;
+			if (!bufferCount || static_cast<double>(liveBlocks) >= trimPolicy.lowUsage * reservedBlocks())
+			{
+				lowUsageChecks = 0;
+				return;
+			}
+			if (++lowUsageChecks >= trimPolicy.sustainedChecks)
+			{
+				lowUsageChecks = 0;
+				trim(trimPolicy.keepBytes);
+			}
+		}
+	};
+
+	// Storage for Count contiguous T; the block of one small-array size class
+	template <class T, std::size_t Count>
+	struct ArrayBlock
+	{
+		alignas(T) uint8_t data[sizeof(T) * Count];
+	};
+
+	// Every pool one allocator family has been rebound to, keyed by pool type. All copies
+	// and rebinds of an allocator share the family, so a node-based container allocates
+	// its nodes from a pool of node-sized blocks, any copy can free what another
+	// allocated, and the pools live exactly as long as the last allocator using them.
+	class PoolFamily
+	{
+		struct Entry
+		{
+			std::shared_ptr<void> pool;
+			std::size_t (*reservedBlocks)(const void* pool);
+			std::size_t (*shrink)(void* pool);
+		};
+
+		std::unordered_map<std::type_index, Entry> pools;
+
+	public:
+		// Pool needs a default constructor, reservedBlocks() and shrink()
+		template <class Pool>
+		Pool* get()
+		{
+			Entry& entry = pools[std::type_index(typeid(Pool))];
+			if (!entry.pool)
+			{
+				entry.pool = std::make_shared<Pool>();
+				entry.reservedBlocks = [](const void* pool) { return static_cast<const Pool*>(pool)->reservedBlocks(); };
+				entry.shrink = [](void* pool) { return static_cast<Pool*>(pool)->shrink(); };
+			}
+			return static_cast<Pool*>(entry.pool.get());
+		}
+
+		std::size_t reservedBlocks() const
+		{
+			std::size_t blocks = 0;
+			for (const auto& entry : pools)
+				blocks += entry.second.reservedBlocks(entry.second.pool.get());
+			return blocks;
+		}
+
+		// Returns the completely free buffers of every pool, returns the bytes released
+		std::size_t shrink()
+		{
+			std::size_t released = 0;
+			for (auto& entry : pools)
+				released += entry.second.shrink(entry.second.pool.get());
+			return released;
+		}
+	};
+
+	// Pools of one element type: single elements, plus the small-array size class pools,
+	// filled in from the family on first use and shared by every copy of the allocator
+	template <class T, std::size_t growSize, std::size_t arrayClasses>
+	struct ElementPools
+	{
+		MemoryPool<T, growSize> elements;
+		void* arrays[arrayClasses] = {};
+
+		std::size_t reservedBlocks() const
+		{
+			return elements.reservedBlocks();
+		}
+
+		std::size_t shrink()
+		{
+			return elements.shrink();
 		}
 	};
 
 	template <class T, std::size_t growSize = GROW_SIZE>
-	class Allocator : private MemoryPool<T, growSize>
+	class Allocator
 	{
+		template <class U, std::size_t>
+		friend class Allocator;
+
 	public:
 		using size_type = std::size_t;
 		using difference_type = std::ptrdiff_t;
@@ -96,24 +356,25 @@ namespace Moya
 		using const_reference = const T&;
 		using value_type = T;
 
-		Allocator() = default;
+		// Allocators of different families are unequal, so the family has to travel with
+		// the nodes; otherwise a swapped container frees into a pool that died with the other
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
 
-		Allocator(Allocator& allocator)
-			: copyAllocator_(&allocator)
+		Allocator()
+			: family_(std::make_shared<PoolFamily>())
+			, pools_(family_->get<Pools<>>())
 		{}
 
-		template <class U>
-		explicit Allocator(const Allocator<U, growSize>& other)
-			: copyAllocator_(nullptr)
-		{
-			if (!std::is_same<T, U>::value)
-				rebindAllocator_ = new std::allocator<T>();
-		}
+		// No move constructor on purpose: a moved-from container keeps a usable allocator
+		Allocator(const Allocator& allocator) = default;
 
-		~Allocator()
-		{
-			delete rebindAllocator_;
-		}
+		template <class U>
+		Allocator(const Allocator<U, growSize>& other)
+			: family_(other.family_)
+			, pools_(family_->get<Pools<>>())
+		{}
 
 		template <class U>
 		struct rebind
@@ -121,33 +382,47 @@ namespace Moya
 			using other = Allocator<U, growSize>;
 		};
 
+		// Single elements come from the element pool, arrays up to maxPooledCount from the
+		// pool of the next power-of-two element count, anything larger from aligned operator new
 		pointer allocate(size_type N, const void* hint = nullptr)
 		{
-			if (copyAllocator_)
-				return copyAllocator_->allocate(N, hint);
+			if (N == 1)
+				return pools()->elements.allocate();
 
-			if (rebindAllocator_)
-				return rebindAllocator_->allocate(N, hint);
-			if (N != 1 || hint)
-				throw std::bad_alloc();
+			if constexpr (maxPooledCount() >= 2)
+			{
+				if (N <= maxPooledCount())
+					return allocateArray<2>(N);
+			}
 
-			return MemoryPool<T, growSize>::allocate();
+			if (N > max_size())
+				throw std::bad_array_new_length();
+			return static_cast<pointer>(::operator new(N * sizeof(T), std::align_val_t(alignof(T))));
 		}
 
 		void deallocate(pointer p, size_type N)
 		{
-			if (copyAllocator_)
+			if (N == 1)
 			{
-				copyAllocator_->deallocate(p, N);
+				pools()->elements.deallocate(p);
 				return;
 			}
 
-			if (rebindAllocator_)
+			if constexpr (maxPooledCount() >= 2)
 			{
-				rebindAllocator_->deallocate(p, N);
-				return;
+				if (N <= maxPooledCount())
+				{
+					deallocateArray<2>(p, N);
+					return;
+				}
 			}
-			MemoryPool<T, growSize>::deallocate(p);
+
+			::operator delete(p, std::align_val_t(alignof(T)));
+		}
+
+		size_type max_size() const noexcept
+		{
+			return std::numeric_limits<size_type>::max() / sizeof(T);
 		}
 
 		static void construct(const pointer p, const_reference val)
@@ -160,9 +435,89 @@ namespace Moya
 			p->~T();
 		}
 
+		// Blocks reserved by every pool of this allocator family
+		std::size_t pooledBlocks() const
+		{
+			return family_->reservedBlocks();
+		}
+
+		// Gives the completely free buffers of the family back, e.g. after a container shrank
+		std::size_t shrinkPools()
+		{
+			return family_->shrink();
+		}
+
+		template <class U>
+		bool operator==(const Allocator<U, growSize>& other) const
+		{
+			return family_ == other.family_;
+		}
+
+		template <class U>
+		bool operator!=(const Allocator<U, growSize>& other) const
+		{
+			return family_ != other.family_;
+		}
+
 	private:
-		Allocator* copyAllocator_{};
-		std::allocator<T>* rebindAllocator_ = nullptr;
+		// Everything sized by T is computed on use, so Allocator<T> can be named while T is
+		// still incomplete, e.g. as the allocator of a container member of T itself
+		static constexpr std::size_t maxPooledCount()
+		{
+			return MAX_POOLED_ARRAY_BYTES / sizeof(T) > 1 ? std::bit_floor(MAX_POOLED_ARRAY_BYTES / sizeof(T)) : 1;
+		}
+
+		template <class U = T>
+		using Pools = ElementPools<U, growSize, std::bit_width(Allocator<U, growSize>::maxPooledCount())>;
+
+		auto pools() const
+		{
+			return static_cast<Pools<>*>(pools_);
+		}
+
+		// Keeps every size class buffer near growSize elements
+		template <std::size_t Count>
+		static constexpr std::size_t arrayGrowSize = (growSize / Count > 0 ? growSize / Count : 1);
+
+		template <std::size_t Count>
+		using ArrayPool = MemoryPool<ArrayBlock<T, Count>, arrayGrowSize<Count>>;
+
+		template <std::size_t Count>
+		ArrayPool<Count>* arrayPool()
+		{
+			void*& pool = pools()->arrays[std::bit_width(Count) - 1];
+			if (!pool)
+				pool = family_->get<ArrayPool<Count>>();
+			return static_cast<ArrayPool<Count>*>(pool);
+		}
+
+		template <std::size_t Count>
+		pointer allocateArray(const size_type N)
+		{
+			if constexpr (Count < maxPooledCount())
+			{
+				if (N > Count)
+					return allocateArray<Count * 2>(N);
+			}
+			return reinterpret_cast<pointer>(arrayPool<Count>()->allocate()->data);
+		}
+
+		template <std::size_t Count>
+		void deallocateArray(const pointer p, const size_type N)
+		{
+			if constexpr (Count < maxPooledCount())
+			{
+				if (N > Count)
+				{
+					deallocateArray<Count * 2>(p, N);
+					return;
+				}
+			}
+			arrayPool<Count>()->deallocate(reinterpret_cast<ArrayBlock<T, Count>*>(p));
+		}
+
+		std::shared_ptr<PoolFamily> family_;
+		void* pools_;
 	};
 }
 
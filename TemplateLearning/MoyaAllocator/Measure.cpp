@@ -1,176 +1,390 @@
-#include <iostream>
+#include "Measure.h"
+
+#include <algorithm>
 #include <chrono>
+#include <forward_list>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <numeric>
 #include <random>
-
 #include <set>
-#include <map>
-#include <list>
-#include <forward_list>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "Allocator.h"
+#include "../TempAllocator.h"
+#include "../PoolAllocator/MemoryResource.h"
+#include "../PoolAllocator/SizeClassAllocator.h"
 
+namespace
+{
+	// Allocator kinds. Each thread of a cell owns one ThreadState, builds every
+	// container of its samples from it and wraps each sample in a SampleScope.
 
-const std::size_t growSize = 1024;
-const int numberOfIterations = 1024;
-const int randomRange = 1024;
+	struct NoSampleScope
+	{
+		template <class ThreadState>
+		explicit NoSampleScope(ThreadState&) {}
+	};
 
-template <typename Container>
-class PerformanceTest
-{
-    virtual void testIteration(int newSize) = 0;
-	
-    protected:
-    ~PerformanceTest() = default;
-    Container container;
-		std::default_random_engine randomNumberGenerator;
-        std::uniform_int_distribution<int> randomNumberDistribution;
-		
-    public:
-		PerformanceTest() 
-			: randomNumberGenerator(0)
-            , randomNumberDistribution(0, randomRange)
-        {}
-
-        double run()
-        {
-            auto from = std::chrono::high_resolution_clock::now();
-
-            for (int i = 0; i < numberOfIterations; i++)
-                testIteration(randomNumberDistribution(randomNumberGenerator));
-
-            auto to = std::chrono::high_resolution_clock::now();
-            return std::chrono::duration_cast<std::chrono::duration<double>>(to - from).count();
-        }
-};
-
-template <typename Container>
-class PushFrontTest : public PerformanceTest<Container>
-{
-    virtual void testIteration(int newSize)
-    {
-        int size = 0;
+	struct StdKind
+	{
+		static constexpr const char* name = "std::allocator";
 
-        while (size < newSize)
-            this->container.push_front(size++);
+		template <class T>
+		using Alloc = std::allocator<T>;
 
-        for (; size > newSize; size--)
-            this->container.pop_front();
-    }
-};
+		struct ThreadState
+		{
+			explicit ThreadState(std::size_t) {}
 
-template <typename Container>
-class PushBackTest : public PerformanceTest<Container>
-{
-    virtual void testIteration(int newSize)
-    {
-        int size = 0;
+			template <class T>
+			Alloc<T> allocator() { return Alloc<T>(); }
+		};
 
-        while (size < newSize)
-            this->container.push_back(size++);
+		using SampleScope = NoSampleScope;
+	};
 
-        for (; size > newSize; size--)
-            this->container.pop_back();
-    }
-};
+	// One allocator family per thread, so pools stay warm across samples
+	struct MoyaKind
+	{
+		static constexpr const char* name = "Moya::Allocator";
 
-template <typename Container>
-class MapTest : public PerformanceTest<Container>
-{
-    virtual void testIteration(int newSize)
-    {
-        int size = 0;
+		template <class T>
+		using Alloc = Moya::Allocator<T>;
 
-        while (size < newSize)
-            this->container.insert(std::pair<char, int>(size++, size));
+		struct ThreadState
+		{
+			Moya::Allocator<int> family;
 
-        while (size > newSize)
-            this->container.erase(--size);
-    }
-};
+			explicit ThreadState(std::size_t) {}
 
-template <typename Container>
-class VectorTest final : public PerformanceTest<Container>
-{
-	void testIteration(const int newSize) override
+			template <class T>
+			Alloc<T> allocator() { return Alloc<T>(family); }
+		};
+
+		using SampleScope = NoSampleScope;
+	};
+
+	// PoolAllocator size classes (16..4096 bytes) behind std::pmr
+	struct PoolKind
 	{
-		int size = 0;
+		static constexpr const char* name = "PoolAllocator";
 
-		for (; size < newSize; ++size)
-			this->container.emplace_back(size);
+		template <class T>
+		using Alloc = std::pmr::polymorphic_allocator<T>;
 
-		size = 0;
-		for (; size < newSize; ++size)
-			this->container.erase(this->container.begin() + size);
-	}
-};
+		struct ThreadState
+		{
+			SizeClassAllocator pools;
+			AllocatorResource resource;
 
-template <typename Container>
-class SetTest : public PerformanceTest<Container>
-{
-    virtual void testIteration(int newSize)
-    {
-        int size = 0;
+			// Every class can hold one node per element of the largest sample
+			explicit ThreadState(std::size_t elements)
+				: pools(std::max<std::size_t>(elements * 64, 64 * 1024))
+				, resource(&pools)
+			{
+				pools.Init();
+			}
 
-        while (size < newSize)
-            this->container.insert(size++);
+			template <class T>
+			Alloc<T> allocator() { return Alloc<T>(&resource); }
+		};
 
-        while (size > newSize)
-            this->container.erase(--size);
-    }
-};
+		using SampleScope = NoSampleScope;
+	};
 
-template <typename StlContainer, typename FastContainer>
-void printTestStatus(const char *name, StlContainer &stlContainer, FastContainer &fastContainer)
-{
-    std::cout << std::fixed;
-    std::cout << name << " - Default STL Allocator : " << stlContainer.run() << " seconds." << std::endl;
-    std::cout << name << " - Memory Pool Allocator : " << fastContainer.run() << " seconds." << std::endl;
-    std::cout << std::endl;
-}
+	// Thread's LinearAllocator through TempStdAllocator, rewound after every sample
+	struct LinearKind
+	{
+		static constexpr const char* name = "LinearAllocator";
 
-int mainMes()
-{
-	using DataType = int;
-	using MemoryPoolAllocator = Moya::Allocator<DataType, growSize>;
+		template <class T>
+		using Alloc = TempStdAllocator<T>;
+
+		struct ThreadState
+		{
+			LinearAllocator arena;
+
+			// Grows by 1 MB blocks; after the first sample they come from the spare list
+			explicit ThreadState(std::size_t)
+				: arena(1 << 20)
+			{
+				tlsLinearAllocator = &arena;
+			}
 
-    std::cout << "Allocator performance measurement example" << std::endl;
-    std::cout << "Version: 1.0" << std::endl << std::endl;
+			~ThreadState()
+			{
+				tlsLinearAllocator = nullptr;
+			}
 
-	std::map<char, int, std::greater<>> mymap;
+			template <class T>
+			Alloc<T> allocator() { return Alloc<T>(); }
+		};
 
-	// allocate an array of 5 elements using my map's allocator:
-	std::pair<const char, int>* p = mymap.get_allocator().allocate(5);
-	p[0].second = 100;
-	p[1].second = 200;
-	p[2].second = 300;
+		struct SampleScope
+		{
+			TempAllocatorScope scope;
 
-	// assign some values to array
-	int psize = sizeof(std::map<char, int>::value_type) * 5;
+			explicit SampleScope(ThreadState&) {}
+		};
+	};
 
-	std::cout << "The allocated array has a size of " << psize << " bytes.\n";
+	// Containers. run() gets the sample's keys, a shuffled 0..elements-1.
 
-	mymap.get_allocator().deallocate(p, 5);
+	struct ListBench
+	{
+		static constexpr const char* name = "list";
+
+		template <class Kind>
+		using Container = std::list<int, typename Kind::template Alloc<int>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			for (const int key : keys)
+				container.push_back(key);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.pop_front();
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.push_back(keys[i]);
+		}
+	};
+
+	struct ForwardListBench
+	{
+		static constexpr const char* name = "forward_list";
+
+		template <class Kind>
+		using Container = std::forward_list<int, typename Kind::template Alloc<int>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			for (const int key : keys)
+				container.push_front(key);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.pop_front();
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.push_front(keys[i]);
+		}
+	};
+
+	// Insert every key, erase the first half, insert it again
+	template <class Container>
+	void runAssociative(Container& container, const std::vector<int>& keys)
+	{
+		for (const int key : keys)
+			container.emplace(key);
+		for (std::size_t i = 0; i < keys.size() / 2; ++i)
+			container.erase(keys[i]);
+		for (std::size_t i = 0; i < keys.size() / 2; ++i)
+			container.emplace(keys[i]);
+	}
+
+	struct MapBench
+	{
+		static constexpr const char* name = "map";
+
+		template <class Kind>
+		using Container = std::map<int, int, std::less<int>, typename Kind::template Alloc<std::pair<const int, int>>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			for (const int key : keys)
+				container.emplace(key, key);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.erase(keys[i]);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.emplace(keys[i], keys[i]);
+		}
+	};
+
+	struct SetBench
+	{
+		static constexpr const char* name = "set";
+
+		template <class Kind>
+		using Container = std::set<int, std::less<int>, typename Kind::template Alloc<int>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			runAssociative(container, keys);
+		}
+	};
+
+	struct UnorderedMapBench
+	{
+		static constexpr const char* name = "unordered_map";
+
+		template <class Kind>
+		using Container = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, typename Kind::template Alloc<std::pair<const int, int>>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			for (const int key : keys)
+				container.emplace(key, key);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.erase(keys[i]);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.emplace(keys[i], keys[i]);
+		}
+	};
+
+	// No reserve, so the growth reallocations are part of the sample
+	struct VectorBench
+	{
+		static constexpr const char* name = "vector";
+
+		template <class Kind>
+		using Container = std::vector<int, typename Kind::template Alloc<int>>;
+
+		template <class Container>
+		static void run(Container& container, const std::vector<int>& keys)
+		{
+			for (const int key : keys)
+				container.push_back(key);
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.pop_back();
+			for (std::size_t i = 0; i < keys.size() / 2; ++i)
+				container.push_back(keys[i]);
+		}
+	};
+
+	double percentile(const std::vector<double>& sorted, const double fraction)
+	{
+		const auto rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()));
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+
+	template <class Bench, class Kind>
+	MatrixResult runCell(const MatrixOptions& options, const std::size_t elements, const unsigned threads)
+	{
+		using Container = typename Bench::template Container<Kind>;
+
+		std::vector<std::vector<double>> samples(threads);
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threads; ++t)
+		{
+			workers.emplace_back([&options, &samples, elements, t]
+			{
+				typename Kind::ThreadState state(elements);
+				std::vector<int> keys(elements);
+				std::iota(keys.begin(), keys.end(), 0);
+				std::shuffle(keys.begin(), keys.end(), std::mt19937(t + 1));
+
+				for (std::size_t rep = 0; rep < options.warmup + options.repetitions; ++rep)
+				{
+					const auto from = std::chrono::steady_clock::now();
+					{
+						typename Kind::SampleScope scope(state);
+						Container container(state.template allocator<typename Container::value_type>());
+						Bench::run(container, keys);
+					}
+					const auto to = std::chrono::steady_clock::now();
+
+					if (rep >= options.warmup)
+						samples[t].push_back(std::chrono::duration<double, std::nano>(to - from).count() / static_cast<double>(elements));
+				}
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+
+		std::vector<double> all;
+		for (const auto& threadSamples : samples)
+			all.insert(all.end(), threadSamples.begin(), threadSamples.end());
+		std::sort(all.begin(), all.end());
+
+		MatrixResult result;
+		result.container = Bench::name;
+		result.allocator = Kind::name;
+		result.elements = elements;
+		result.threads = threads;
+		result.samples = all.size();
+		result.medianNs = percentile(all, 0.5);
+		result.p99Ns = percentile(all, 0.99);
+		result.meanNs = std::accumulate(all.begin(), all.end(), 0.0) / static_cast<double>(all.size());
+		result.minNs = all.front();
+		return result;
+	}
 
-//     PushFrontTest<std::forward_list<DataType>> pushFrontForwardListTestStl;
-//     PushFrontTest<std::forward_list<DataType, MemoryPoolAllocator>> pushFrontForwardListTestFast;
-//     printTestStatus("ForwardList PushFront", pushFrontForwardListTestStl, pushFrontForwardListTestFast);
+	template <class Bench>
+	void runContainer(const MatrixOptions& options, std::ostream& out)
+	{
+		const auto report = [&options, &out](const MatrixResult& result)
+		{
+			if (options.csv)
+				writeMatrixCsvLine(out, result);
+			else
+				writeMatrixJsonLine(out, result);
+			out.flush();
+		};
+
+		for (const auto elements : options.sizes)
+		{
+			for (const auto threads : options.threadCounts)
+			{
+				report(runCell<Bench, StdKind>(options, elements, threads));
+				report(runCell<Bench, MoyaKind>(options, elements, threads));
+				report(runCell<Bench, PoolKind>(options, elements, threads));
+				report(runCell<Bench, LinearKind>(options, elements, threads));
+			}
+		}
+	}
+}
 
-//     PushFrontTest<std::list<DataType>> pushFrontListTestStl;
-//     PushFrontTest<std::list<DataType, MemoryPoolAllocator>> pushFrontListTestFast;
-//     printTestStatus("List PushFront", pushFrontListTestStl, pushFrontListTestFast);
+void writeMatrixJsonLine(std::ostream& out, const MatrixResult& result)
+{
+	out << "{\"container\":\"" << result.container << "\""
+		<< ",\"allocator\":\"" << result.allocator << "\""
+		<< ",\"elements\":" << result.elements
+		<< ",\"threads\":" << result.threads
+		<< ",\"samples\":" << result.samples
+		<< ",\"median_ns_per_element\":" << result.medianNs
+		<< ",\"p99_ns_per_element\":" << result.p99Ns
+		<< ",\"mean_ns_per_element\":" << result.meanNs
+		<< ",\"min_ns_per_element\":" << result.minNs
+		<< "}\n";
+}
 
-//     PushBackTest<std::list<DataType>> pushBackListTestStl;
-//     PushBackTest<std::list<DataType, MemoryPoolAllocator>> pushBackListTestFast;
-//     printTestStatus("List PushBack", pushBackListTestStl, pushBackListTestFast);
+void writeMatrixCsvHeader(std::ostream& out)
+{
+	out << "container,allocator,elements,threads,samples,median_ns_per_element,p99_ns_per_element,mean_ns_per_element,min_ns_per_element\n";
+}
 
-	MapTest<std::map<DataType, DataType, std::less<>>> mapTestStl;
-	MapTest<std::map<DataType, DataType, std::less<>, MemoryPoolAllocator>> mapTestFast;
-	printTestStatus("Map", mapTestStl, mapTestFast);
+void writeMatrixCsvLine(std::ostream& out, const MatrixResult& result)
+{
+	out << result.container << ',' << result.allocator << ',' << result.elements << ',' << result.threads << ','
+		<< result.samples << ',' << result.medianNs << ',' << result.p99Ns << ',' << result.meanNs << ','
+		<< result.minNs << '\n';
+}
 
-    SetTest<std::set<DataType, std::less<>>> setTestStl;
-    SetTest<std::set<DataType, std::less<>, MemoryPoolAllocator>> setTestFast;
-    printTestStatus("Set", setTestStl, setTestFast);
+void runContainerMatrix(const MatrixOptions& options, std::ostream& out)
+{
+	if (options.csv)
+		writeMatrixCsvHeader(out);
+
+	runContainer<ListBench>(options, out);
+	runContainer<ForwardListBench>(options, out);
+	runContainer<MapBench>(options, out);
+	runContainer<SetBench>(options, out);
+	runContainer<UnorderedMapBench>(options, out);
+	runContainer<VectorBench>(options, out);
+}
 
+int mainMes()
+{
+	MatrixOptions options;
+	options.threadCounts = { 1, std::max(2u, std::thread::hardware_concurrency()) };
+	options.csv = true;
+	runContainerMatrix(options, std::cout);
 
-    return getchar();
+	return getchar();
 }
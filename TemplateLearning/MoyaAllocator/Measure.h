@@ -0,0 +1,41 @@
+#ifndef MeasureH
+#define MeasureH
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Container x allocator benchmark matrix. Every cell runs warmup + repetitions
+// samples per thread; a sample builds one container of `elements` values,
+// churns half of them and destroys it, and is recorded as ns per element.
+struct MatrixOptions
+{
+	std::vector<std::size_t> sizes{ 1024, 65536 };
+	std::vector<unsigned> threadCounts{ 1 };
+	std::size_t warmup = 2;
+	std::size_t repetitions = 20;
+	bool csv = false;
+};
+
+struct MatrixResult
+{
+	std::string container;
+	std::string allocator;
+	std::size_t elements;
+	unsigned threads;
+	std::size_t samples;
+	double medianNs;
+	double p99Ns;
+	double meanNs;
+	double minNs;
+};
+
+void writeMatrixJsonLine(std::ostream& out, const MatrixResult& result);
+void writeMatrixCsvHeader(std::ostream& out);
+void writeMatrixCsvLine(std::ostream& out, const MatrixResult& result);
+
+// Runs every container with every allocator for every size and thread count
+void runContainerMatrix(const MatrixOptions& options, std::ostream& out);
+
+#endif
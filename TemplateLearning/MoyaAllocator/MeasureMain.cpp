@@ -0,0 +1,57 @@
+#include "Measure.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Container x allocator benchmark matrix, one JSON object (or CSV row with
+// --csv) per cell on stdout.
+//   container_benchmark [--csv] [--sizes N,N..] [--threads N,N..] [--repetitions N] [--warmup N]
+
+namespace
+{
+	template <class T>
+	std::vector<T> parseList(const char* text)
+	{
+		std::vector<T> values;
+		std::stringstream stream(text);
+		std::string item;
+		while (std::getline(stream, item, ','))
+			values.push_back(static_cast<T>(std::stoul(item)));
+		return values;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	MatrixOptions options;
+	options.threadCounts = { 1, std::max(2u, std::thread::hardware_concurrency()) };
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--csv") == 0)
+			options.csv = true;
+		else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+			options.sizes = parseList<std::size_t>(argv[++i]);
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			options.threadCounts = parseList<unsigned>(argv[++i]);
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			options.repetitions = std::stoul(argv[++i]);
+		else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+			options.warmup = std::stoul(argv[++i]);
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--csv] [--sizes N,N..] [--threads N,N..] [--repetitions N] [--warmup N]" << std::endl;
+			return 1;
+		}
+	}
+	if (options.sizes.empty() || options.threadCounts.empty() || options.repetitions == 0)
+	{
+		std::cerr << "sizes, threads and repetitions must not be empty" << std::endl;
+		return 1;
+	}
+
+	runContainerMatrix(options, std::cout);
+	return 0;
+}
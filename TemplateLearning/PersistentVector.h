@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "PoolAllocator/MappedFile.h"
+
+// Growable array of trivially copyable elements living in a memory-mapped
+// file. The file starts with a small header (magic, version, element size,
+// count) and the elements follow it, so reopening maps the file and uses the
+// data in place: no parsing, no copying, O(1) whatever the size. Growth
+// extends the file and remaps it, which invalidates pointers into the vector.
+//
+// The count is stored in the mapping, so every change reaches the file without
+// an explicit save; Flush() forces it to disk. The layout is the in-memory one,
+// so a file is only portable between builds with the same T, endianness and
+// struct packing.
+template <class T>
+class PersistentVector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "PersistentVector stores elements by their bytes");
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t elementSize;
+		std::uint64_t count;
+	};
+
+	static constexpr char Magic[8] = { 'P', 'V', 'E', 'C', 'T', 'O', 'R', '\0' };
+	static constexpr std::uint32_t Version = 1;
+	// Elements start on a cache line (or T's alignment if that is larger)
+	static constexpr std::size_t DataOffset = (sizeof(Header) + 63) / 64 * 64 > alignof(T) ? (sizeof(Header) + 63) / 64 * 64 : alignof(T);
+	// Smallest file growth, so push_back does not remap every page
+	static constexpr std::size_t MinGrowBytes = 64 * 1024;
+
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	// Opens path or creates it empty. Throws std::runtime_error if the file cannot
+	// be mapped or was written for another element type or format version.
+	explicit PersistentVector(const std::string& path)
+	{
+		if (!m_File.Open(path))
+			throw std::runtime_error("PersistentVector: cannot open " + path);
+
+		if (m_File.Size() == 0)
+		{
+			if (!m_File.Resize(DataOffset))
+				throw std::runtime_error("PersistentVector: cannot create " + path);
+			Header* header = GetHeader();
+			std::memcpy(header->magic, Magic, sizeof(Magic));
+			header->version = Version;
+			header->elementSize = sizeof(T);
+			header->count = 0;
+			return;
+		}
+
+		const Header* header = GetHeader();
+		if (m_File.Size() < DataOffset || std::memcmp(header->magic, Magic, sizeof(Magic)) != 0)
+			throw std::runtime_error("PersistentVector: " + path + " is not a vector file");
+		if (header->version != Version || header->elementSize != sizeof(T))
+			throw std::runtime_error("PersistentVector: " + path + " holds another version or element type");
+		if (header->count > capacity())
+			throw std::runtime_error("PersistentVector: " + path + " is truncated");
+	}
+
+	PersistentVector(const PersistentVector&) = delete;
+	PersistentVector& operator=(const PersistentVector&) = delete;
+
+	void reserve(size_type count)
+	{
+		if (count <= capacity())
+			return;
+		size_type bytes = count * sizeof(T);
+		const size_type grown = m_File.Size() - DataOffset + (m_File.Size() - DataOffset) / 2;
+		bytes = bytes > grown ? bytes : grown;
+		bytes = bytes > MinGrowBytes ? bytes : MinGrowBytes;
+		if (!m_File.Resize(DataOffset + bytes))
+			throw std::runtime_error("PersistentVector: cannot grow the file");
+	}
+
+	// New elements are zero-filled (the file is extended with zeros)
+	void resize(size_type count)
+	{
+		reserve(count);
+		if (count > size())
+			std::memset(static_cast<void*>(data() + size()), 0, (count - size()) * sizeof(T));
+		GetHeader()->count = count;
+	}
+
+	void push_back(const T& value)
+	{
+		if (size() == capacity())
+		{
+			// value may live in the mapping that is about to move
+			const T copy = value;
+			reserve(size() + 1);
+			data()[GetHeader()->count++] = copy;
+			return;
+		}
+		data()[GetHeader()->count++] = value;
+	}
+
+	void pop_back() { --GetHeader()->count; }
+
+	void clear() { GetHeader()->count = 0; }
+
+	// Cuts the file down to the elements in use
+	void shrink_to_fit()
+	{
+		if (!m_File.Resize(DataOffset + size() * sizeof(T)))
+			throw std::runtime_error("PersistentVector: cannot shrink the file");
+	}
+
+	void Flush() { m_File.Flush(); }
+
+	T& operator[](size_type index) { return data()[index]; }
+	const T& operator[](size_type index) const { return data()[index]; }
+
+	T& back() { return data()[size() - 1]; }
+
+	T* data() { return reinterpret_cast<T*>(static_cast<char*>(m_File.Data()) + DataOffset); }
+	const T* data() const { return reinterpret_cast<const T*>(static_cast<const char*>(m_File.Data()) + DataOffset); }
+
+	iterator begin() { return data(); }
+	iterator end() { return data() + size(); }
+	const_iterator begin() const { return data(); }
+	const_iterator end() const { return data() + size(); }
+
+	size_type size() const { return static_cast<size_type>(GetHeader()->count); }
+	size_type capacity() const { return (m_File.Size() - DataOffset) / sizeof(T); }
+	bool empty() const { return size() == 0; }
+
+private:
+	Header* GetHeader() { return static_cast<Header*>(m_File.Data()); }
+	const Header* GetHeader() const { return static_cast<const Header*>(m_File.Data()); }
+
+	MappedFile m_File;
+};
@@ -4,6 +4,7 @@
 Allocator::Allocator(const std::size_t totalSize){
     m_totalSize = totalSize;
     m_used = 0;
+    m_peak = 0;
 }
 
 Allocator::~Allocator(){
@@ -0,0 +1,337 @@
+#include "Benchmark.h"
+#include <algorithm>    /* max, nth_element, shuffle */
+#include <chrono>
+#include <numeric>      /* iota */
+#include <random>
+#include <stdlib.h>     /* malloc, free */
+#include <thread>
+#ifdef __linux__
+#include <malloc.h>     /* malloc_usable_size */
+#endif
+
+AllocatorTarget::AllocatorTarget(std::unique_ptr<Allocator> allocator, const bool fixedSize, const bool lifoOnly, const bool largeBuffers,
+                                 const bool threadSafe)
+: m_allocator(std::move(allocator))
+, m_fixedSize(fixedSize)
+, m_lifoOnly(lifoOnly)
+, m_largeBuffers(largeBuffers)
+, m_threadSafe(threadSafe) {
+    m_allocator->Init();
+}
+
+void* AllocatorTarget::Allocate(const std::size_t size, const std::size_t alignment) {
+    return m_allocator->Allocate(size, alignment);
+}
+
+void AllocatorTarget::Free(void* ptr, const std::size_t size) {
+    m_allocator->Free(ptr);
+}
+
+std::size_t AllocatorTarget::PeakBytes() const {
+    return Benchmark::Peak(*m_allocator);
+}
+
+void* MallocTarget::Allocate(const std::size_t size, const std::size_t alignment) {
+    void* ptr = malloc(size);
+#ifdef __linux__
+    const std::size_t bytes = malloc_usable_size(ptr);
+#else
+    const std::size_t bytes = size;
+#endif
+    const std::size_t used = m_used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t peak = m_peak.load(std::memory_order_relaxed);
+    while (peak < used && !m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+    return ptr;
+}
+
+void MallocTarget::Free(void* ptr, const std::size_t size) {
+#ifdef __linux__
+    m_used.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+#else
+    m_used.fetch_sub(size, std::memory_order_relaxed);
+#endif
+    free(ptr);
+}
+
+Benchmark::Benchmark(const std::size_t blockSize, const std::size_t batch, const std::size_t rounds)
+: m_blockSize(blockSize)
+, m_batch(batch)
+, m_rounds(rounds) {
+
+}
+
+bool Benchmark::Run(const std::string& name, const TargetFactory& factory, const Workload workload, const unsigned threads, const bool shared,
+                    BenchmarkResult& result) const {
+    std::vector<std::unique_ptr<BenchmarkTarget>> targets;
+    for (unsigned t = 0; t < (shared ? 1 : threads); ++t) {
+        targets.push_back(factory(shared ? threads : 1));
+    }
+    if ((workload == Workload::MixedSizes && targets.front()->FixedSize()) ||
+        (workload != Workload::Lifo && targets.front()->LifoOnly()) ||
+        (workload == Workload::BufferChurn && !targets.front()->LargeBuffers()) ||
+        (shared && !targets.front()->ThreadSafe())) {
+        return false;
+    }
+
+    ClockOverheadNs();
+    SharedRequested sharedRequested;
+    std::vector<ThreadStats> stats(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        BenchmarkTarget& target = *targets[shared ? 0 : t];
+        stats[t].shared = shared ? &sharedRequested : nullptr;
+        workers.emplace_back([&, t] { RunThread(target, workload, t + 1, stats[t]); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<std::uint32_t> latencies;
+    result = BenchmarkResult{};
+    for (auto& threadStats : stats) {
+        latencies.insert(latencies.end(), threadStats.latencies.begin(), threadStats.latencies.end());
+        result.operations += threadStats.operations;
+        if (threadStats.busyNs > 0) {
+            result.opsPerSecond += threadStats.operations / (threadStats.busyNs * 1e-9);
+        }
+        result.requestedPeakBytes += threadStats.requestedPeakBytes;
+        result.failures += threadStats.failures;
+    }
+    for (const auto& target : targets) {
+        result.peakBytes += target->PeakBytes();
+    }
+    if (shared) {
+        // Per-thread peaks need not coincide, so their sum would overstate the shared target's load
+        result.requestedPeakBytes = sharedRequested.peak.load(std::memory_order_relaxed);
+    }
+
+    auto percentile = [&latencies](const double fraction) {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        auto nth = latencies.begin() + static_cast<std::ptrdiff_t>(fraction * (latencies.size() - 1));
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        return static_cast<double>(*nth);
+    };
+
+    result.allocator = name;
+    result.workload = workload;
+    result.threads = threads;
+    result.shared = shared;
+    result.p50Ns = percentile(0.50);
+    result.p90Ns = percentile(0.90);
+    result.p99Ns = percentile(0.99);
+    result.p999Ns = percentile(0.999);
+    result.fragmentation = result.peakBytes > 0
+        ? 1.0 - static_cast<double>(result.requestedPeakBytes) / result.peakBytes
+        : 0.0;
+    return true;
+}
+
+void Benchmark::SharedRequested::Add(const std::size_t bytes) {
+    const std::size_t live = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t high = peak.load(std::memory_order_relaxed);
+    while (high < live && !peak.compare_exchange_weak(high, live, std::memory_order_relaxed)) {
+    }
+}
+
+template <class Op>
+inline void Benchmark::Sampled(ThreadStats& stats, Op&& op) {
+    using Clock = std::chrono::steady_clock;
+
+    if (stats.operations++ % LatencySampleInterval != 0) {
+        op();
+        return;
+    }
+    const auto before = Clock::now();
+    op();
+    const auto after = Clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(after - before).count() - ClockOverheadNs();
+    stats.latencies.push_back(static_cast<std::uint32_t>(std::max(ns, 0.0)));
+}
+
+double Benchmark::ClockOverheadNs() {
+    using Clock = std::chrono::steady_clock;
+
+    // Median of back-to-back reads, measured once
+    static const double overhead = [] {
+        std::vector<double> samples(1001);
+        for (auto& sample : samples) {
+            const auto before = Clock::now();
+            const auto after = Clock::now();
+            sample = std::chrono::duration<double, std::nano>(after - before).count();
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }();
+    return overhead;
+}
+
+void Benchmark::RunThread(BenchmarkTarget& target, const Workload workload, const unsigned seed, ThreadStats& stats) const {
+    using Clock = std::chrono::steady_clock;
+
+    if (workload == Workload::BufferChurn) {
+        RunBufferChurn(target, seed, stats);
+        return;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> mixedSize(2, 128);
+    std::vector<void*> ptrs(m_batch);
+    std::vector<std::size_t> sizes(m_batch, m_blockSize);
+    std::vector<std::size_t> order(m_batch);
+    stats.latencies.reserve(2 * m_batch * m_rounds / LatencySampleInterval + 1);
+
+    for (std::size_t round = 0; round < m_rounds; ++round) {
+        if (stats.shared == nullptr) {
+            target.Reset();
+        }
+        if (workload == Workload::MixedSizes) {
+            for (auto& size : sizes) {
+                size = mixedSize(rng) * 8;
+            }
+        }
+
+        std::size_t requested = 0;
+        auto batchStart = Clock::now();
+        for (std::size_t i = 0; i < m_batch; ++i) {
+            Sampled(stats, [&] { ptrs[i] = target.Allocate(sizes[i], 8); });
+
+            if (ptrs[i] == nullptr) {
+                ++stats.failures;
+                continue;
+            }
+            requested += sizes[i];
+            // Other threads allocate and free meanwhile, so a shared run tracks the live
+            // total per operation, as the buffer churn workload does
+            if (stats.shared != nullptr) {
+                stats.shared->Add(sizes[i]);
+            }
+        }
+        stats.busyNs += std::chrono::duration<double, std::nano>(Clock::now() - batchStart).count();
+        stats.requestedPeakBytes = std::max(stats.requestedPeakBytes, requested);
+
+        std::iota(order.begin(), order.end(), 0);
+        if (workload == Workload::Lifo) {
+            std::reverse(order.begin(), order.end());
+        } else if (workload != Workload::Fifo) {
+            std::shuffle(order.begin(), order.end(), rng);
+        }
+
+        batchStart = Clock::now();
+        for (const auto index : order) {
+            if (ptrs[index] == nullptr) {
+                continue;
+            }
+            Sampled(stats, [&] { target.Free(ptrs[index], sizes[index]); });
+            if (stats.shared != nullptr) {
+                stats.shared->Sub(sizes[index]);
+            }
+        }
+        stats.busyNs += std::chrono::duration<double, std::nano>(Clock::now() - batchStart).count();
+    }
+}
+
+void Benchmark::RunBufferChurn(BenchmarkTarget& target, const unsigned seed, ThreadStats& stats) const {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t LIVE_BUFFERS = 64;
+    constexpr std::size_t MIN_BUFFER = 4096;
+    constexpr int MAX_SHIFT = 10;   // 4 KB << 10 = 4 MB
+
+    std::mt19937 rng(seed);
+    std::geometric_distribution<int> shift(0.4);
+    std::uniform_int_distribution<std::size_t> victim(0, LIVE_BUFFERS - 1);
+    auto nextSize = [&] { return MIN_BUFFER << std::min(shift(rng), MAX_SHIFT); };
+
+    std::vector<void*> ptrs(LIVE_BUFFERS, nullptr);
+    std::vector<std::size_t> sizes(LIVE_BUFFERS, 0);
+    std::size_t requested = 0;
+    auto allocate = [&](const std::size_t index) {
+        sizes[index] = nextSize();
+        Sampled(stats, [&] { ptrs[index] = target.Allocate(sizes[index], MIN_BUFFER); });
+        if (ptrs[index] == nullptr) {
+            ++stats.failures;
+            return;
+        }
+        requested += sizes[index];
+        stats.requestedPeakBytes = std::max(stats.requestedPeakBytes, requested);
+        // The live set changes every step, so a shared run tracks it per operation
+        if (stats.shared != nullptr) {
+            stats.shared->Add(sizes[index]);
+        }
+    };
+    auto release = [&](const std::size_t index) {
+        if (ptrs[index] == nullptr) {
+            return;
+        }
+        Sampled(stats, [&] { target.Free(ptrs[index], sizes[index]); });
+        requested -= sizes[index];
+        if (stats.shared != nullptr) {
+            stats.shared->Sub(sizes[index]);
+        }
+        ptrs[index] = nullptr;
+    };
+
+    stats.latencies.reserve(2 * (m_batch + LIVE_BUFFERS) * m_rounds / LatencySampleInterval + 1);
+    for (std::size_t round = 0; round < m_rounds; ++round) {
+        if (stats.shared == nullptr) {
+            target.Reset();
+        }
+        // The whole round is one batch; size and victim draws are cheap next to 4 KB+ allocations
+        const auto batchStart = Clock::now();
+        for (std::size_t i = 0; i < LIVE_BUFFERS; ++i) {
+            allocate(i);
+        }
+        for (std::size_t step = 0; step < m_batch; ++step) {
+            const std::size_t index = victim(rng);
+            release(index);
+            allocate(index);
+        }
+        for (std::size_t i = 0; i < LIVE_BUFFERS; ++i) {
+            release(i);
+        }
+        stats.busyNs += std::chrono::duration<double, std::nano>(Clock::now() - batchStart).count();
+    }
+}
+
+const char* Benchmark::WorkloadName(const Workload workload) {
+    switch (workload) {
+        case Workload::Lifo: return "lifo";
+        case Workload::Fifo: return "fifo";
+        case Workload::Random: return "random";
+        case Workload::MixedSizes: return "mixed";
+        case Workload::BufferChurn: return "buffers";
+    }
+    return "unknown";
+}
+
+void Benchmark::WriteJsonLine(std::ostream& out, const BenchmarkResult& result) {
+    out << "{\"allocator\":\"" << result.allocator << "\""
+        << ",\"workload\":\"" << WorkloadName(result.workload) << "\""
+        << ",\"threads\":" << result.threads
+        << ",\"shared\":" << (result.shared ? "true" : "false")
+        << ",\"ops\":" << result.operations
+        << ",\"ops_per_sec\":" << result.opsPerSecond
+        << ",\"p50_ns\":" << result.p50Ns
+        << ",\"p90_ns\":" << result.p90Ns
+        << ",\"p99_ns\":" << result.p99Ns
+        << ",\"p999_ns\":" << result.p999Ns
+        << ",\"peak_bytes\":" << result.peakBytes
+        << ",\"requested_peak_bytes\":" << result.requestedPeakBytes
+        << ",\"fragmentation\":" << result.fragmentation
+        << ",\"failures\":" << result.failures
+        << "}\n";
+}
+
+void Benchmark::WriteCsvHeader(std::ostream& out) {
+    out << "allocator,workload,threads,shared,ops,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,peak_bytes,requested_peak_bytes,fragmentation,failures\n";
+}
+
+void Benchmark::WriteCsvLine(std::ostream& out, const BenchmarkResult& result) {
+    out << result.allocator << ',' << WorkloadName(result.workload) << ',' << result.threads << ',' << (result.shared ? 1 : 0) << ','
+        << result.operations << ',' << result.opsPerSecond << ','
+        << result.p50Ns << ',' << result.p90Ns << ',' << result.p99Ns << ',' << result.p999Ns << ','
+        << result.peakBytes << ',' << result.requestedPeakBytes << ',' << result.fragmentation << ','
+        << result.failures << '\n';
+}
@@ -0,0 +1,172 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "Allocator.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Uniform face of every allocator under test. Fixed-size allocators only ever
+// see chunkSize requests; LIFO-only allocators only get LIFO workloads.
+class BenchmarkTarget {
+public:
+    virtual ~BenchmarkTarget() = default;
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment) = 0;
+
+    virtual void Free(void* ptr, const std::size_t size) = 0;
+
+    // Start of a round: every block of the previous round has been freed.
+    // Not called on a target shared between threads.
+    virtual void Reset() {}
+
+    // High-water mark of the bytes the allocator itself had to hand out
+    virtual std::size_t PeakBytes() const = 0;
+
+    virtual bool FixedSize() const { return false; }
+
+    virtual bool LifoOnly() const { return false; }
+
+    // Can serve the 4 KB..4 MB requests of the buffer churn workload
+    virtual bool LargeBuffers() const { return false; }
+
+    // Can be shared by several threads at once
+    virtual bool ThreadSafe() const { return false; }
+};
+
+// Adapter for the Allocator hierarchy; reads m_used/m_peak through friendship
+class AllocatorTarget : public BenchmarkTarget {
+    std::unique_ptr<Allocator> m_allocator;
+    bool m_fixedSize;
+    bool m_lifoOnly;
+    bool m_largeBuffers;
+    bool m_threadSafe;
+public:
+    AllocatorTarget(std::unique_ptr<Allocator> allocator, const bool fixedSize, const bool lifoOnly, const bool largeBuffers = false,
+                    const bool threadSafe = false);
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment) override;
+
+    virtual void Free(void* ptr, const std::size_t size) override;
+
+    virtual std::size_t PeakBytes() const override;
+
+    virtual bool FixedSize() const override { return m_fixedSize; }
+
+    virtual bool LifoOnly() const override { return m_lifoOnly; }
+
+    virtual bool LargeBuffers() const override { return m_largeBuffers; }
+
+    virtual bool ThreadSafe() const override { return m_threadSafe; }
+};
+
+class MallocTarget : public BenchmarkTarget {
+    std::atomic<std::size_t> m_used{0};
+    std::atomic<std::size_t> m_peak{0};
+public:
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment) override;
+
+    virtual void Free(void* ptr, const std::size_t size) override;
+
+    virtual std::size_t PeakBytes() const override { return m_peak.load(std::memory_order_relaxed); }
+
+    virtual bool LargeBuffers() const override { return true; }
+
+    virtual bool ThreadSafe() const override { return true; }
+};
+
+enum class Workload {
+    Lifo,       // free in reverse allocation order
+    Fifo,       // free in allocation order
+    Random,     // free in shuffled order
+    MixedSizes, // 16..1024 byte requests, shuffled free order
+    BufferChurn // power-of-two 4 KB..4 MB buffers, small ones most common;
+                // a fixed live set where every step frees a random buffer and allocates a new one
+};
+
+struct BenchmarkResult {
+    std::string allocator;
+    Workload workload;
+    unsigned threads;
+    // All threads used one target instead of one each
+    bool shared;
+    std::size_t operations;
+    // Summed over threads, each timed over whole allocate/free batches
+    double opsPerSecond;
+    // Of every LatencySampleInterval-th operation, clock overhead subtracted
+    double p50Ns, p90Ns, p99Ns, p999Ns;
+    std::size_t peakBytes;
+    std::size_t requestedPeakBytes;
+    // 1 - requested / handed out at peak; internal waste of the allocator
+    double fragmentation;
+    std::size_t failures;
+};
+
+class Benchmark {
+public:
+    // Argument: number of threads that will use the target (1 unless shared)
+    using TargetFactory = std::function<std::unique_ptr<BenchmarkTarget>(const unsigned)>;
+
+    // Only one operation in this many is timed on its own for the latency percentiles;
+    // timing each one would cost about as much as the operation
+    static constexpr std::size_t LatencySampleInterval = 64;
+
+    // blockSize: request size of the fixed-size workloads, batch: live blocks per round
+    Benchmark(const std::size_t blockSize, const std::size_t batch, const std::size_t rounds);
+
+    // Every thread runs the same workload, on a target of its own from the factory
+    // or, with shared, all on one target so they contend for it. Returns false (and
+    // leaves result untouched) if the target cannot run it.
+    bool Run(const std::string& name, const TargetFactory& factory, const Workload workload, const unsigned threads, const bool shared,
+             BenchmarkResult& result) const;
+
+    static void WriteJsonLine(std::ostream& out, const BenchmarkResult& result);
+    static void WriteCsvHeader(std::ostream& out);
+    static void WriteCsvLine(std::ostream& out, const BenchmarkResult& result);
+
+    static const char* WorkloadName(const Workload workload);
+
+    static std::size_t Used(const Allocator& allocator) { return allocator.m_used; }
+    static std::size_t Peak(const Allocator& allocator) { return allocator.m_peak; }
+private:
+    // Requested bytes live across all threads of a shared run, and their high-water mark
+    struct SharedRequested {
+        std::atomic<std::size_t> current{0};
+        std::atomic<std::size_t> peak{0};
+
+        void Add(const std::size_t bytes);
+        void Sub(const std::size_t bytes) { current.fetch_sub(bytes, std::memory_order_relaxed); }
+    };
+
+    struct ThreadStats {
+        // Set in shared runs: requested bytes go here instead of requestedPeakBytes
+        SharedRequested* shared = nullptr;
+        std::vector<std::uint32_t> latencies;
+        std::size_t operations = 0;
+        // Time spent inside the timed batches
+        double busyNs = 0;
+        std::size_t requestedPeakBytes = 0;
+        std::size_t failures = 0;
+    };
+
+    std::size_t m_blockSize;
+    std::size_t m_batch;
+    std::size_t m_rounds;
+
+    void RunBufferChurn(BenchmarkTarget& target, const unsigned seed, ThreadStats& stats) const;
+    void RunThread(BenchmarkTarget& target, const Workload workload, const unsigned seed, ThreadStats& stats) const;
+
+    // Runs op, timing it on its own if it is a latency sample
+    template <class Op>
+    static void Sampled(ThreadStats& stats, Op&& op);
+
+    // Cost of the two clock reads around a sampled operation
+    static double ClockOverheadNs();
+};
+
+#endif /* BENCHMARK_H */
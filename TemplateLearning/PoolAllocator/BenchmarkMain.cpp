@@ -0,0 +1,216 @@
+#include "Benchmark.h"
+#include "BuddyAllocator.h"
+#include "FreeListAllocator.h"
+#include "GrowablePoolAllocator.h"
+#include "PoolAllocator.h"
+#include "ShardedPoolAllocator.h"
+#include "StackAllocator.h"
+#include "ThreadCachePoolAllocator.h"
+#include "../LinearAllocator.h"
+#include "../MoyaAllocator/Allocator.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Allocator benchmark suite: every allocator through the same workloads,
+// one JSON object (or CSV row with --csv) per run on stdout. Multi-threaded
+// runs give every thread a private allocator, then (for the thread-safe ones)
+// share a single allocator between all threads to measure contention.
+// --check only runs the allocator regression checks and exits non-zero on failure.
+//   allocator_benchmark [--csv] [--batch N] [--rounds N] [--threads N] [--check]
+
+namespace {
+    constexpr std::size_t BLOCK_SIZE = 64;
+    constexpr std::size_t MAX_MIXED_SIZE = 1024;
+    // Room for the churn workload's 64 live buffers even when several are 4 MB
+    constexpr std::size_t BUDDY_ARENA_SIZE = std::size_t(256) << 20;
+
+    struct Block {
+        unsigned char bytes[BLOCK_SIZE];
+    };
+
+    class MoyaTarget : public BenchmarkTarget {
+        Moya::MemoryPool<Block> m_pool;
+        std::size_t m_live = 0;
+        std::size_t m_peakLive = 0;
+    public:
+        virtual void* Allocate(const std::size_t size, const std::size_t alignment) override {
+            m_peakLive = std::max(m_peakLive, ++m_live);
+            return m_pool.allocate();
+        }
+
+        virtual void Free(void* ptr, const std::size_t size) override {
+            --m_live;
+            m_pool.deallocate(static_cast<Block*>(ptr));
+        }
+
+        // The pool keeps whole buffers of GROW_SIZE blocks
+        virtual std::size_t PeakBytes() const override {
+            return (m_peakLive + GROW_SIZE - 1) / GROW_SIZE * GROW_SIZE * sizeof(Block);
+        }
+
+        virtual bool FixedSize() const override { return true; }
+    };
+
+    // Peak is the memory reserved in slabs, not the chunks handed out
+    class GrowableTarget : public BenchmarkTarget {
+        GrowablePoolAllocator m_allocator;
+        std::size_t m_peak = 0;
+    public:
+        explicit GrowableTarget(const std::size_t initialSize)
+        : m_allocator(initialSize, BLOCK_SIZE) {
+            m_allocator.Init();
+        }
+
+        virtual void* Allocate(const std::size_t size, const std::size_t alignment) override {
+            void* ptr = m_allocator.Allocate(size, alignment);
+            m_peak = std::max(m_peak, m_allocator.ReservedSize());
+            return ptr;
+        }
+
+        virtual void Free(void* ptr, const std::size_t size) override {
+            m_allocator.Free(ptr);
+        }
+
+        virtual std::size_t PeakBytes() const override { return m_peak; }
+
+        virtual bool FixedSize() const override { return true; }
+    };
+
+    // A spike that is freed again must not make the next spike reserve more
+    bool CheckGrowableSpikes() {
+        constexpr std::size_t SPIKE = 40;
+        constexpr std::size_t ROUNDS = 20;
+        GrowablePoolAllocator pool(16 * BLOCK_SIZE, BLOCK_SIZE);
+        pool.Init();
+        std::vector<void*> chunks(SPIKE);
+        std::size_t firstPeak = 0;
+        for (std::size_t round = 0; round < ROUNDS; ++round) {
+            for (auto& chunk : chunks) {
+                chunk = pool.Allocate(BLOCK_SIZE);
+            }
+            const std::size_t peak = pool.ReservedSize();
+            for (auto chunk : chunks) {
+                pool.Free(chunk);
+            }
+            if (round == 0) {
+                firstPeak = peak;
+            } else if (peak != firstPeak) {
+                std::cerr << "GrowablePoolAllocator: round " << round << " reserved " << peak << " bytes, round 0 reserved " << firstPeak << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    class LinearTarget : public BenchmarkTarget {
+        LinearAllocator m_allocator;
+        std::size_t m_peak = 0;
+    public:
+        explicit LinearTarget(const std::size_t blockSize)
+        : m_allocator(blockSize) {
+        }
+
+        virtual void* Allocate(const std::size_t size, const std::size_t alignment) override {
+            void* ptr = m_allocator.Allocate(size, static_cast<unsigned>(alignment));
+            m_peak = std::max(m_peak, m_allocator.UsedBytes());
+            return ptr;
+        }
+
+        virtual void Free(void* ptr, const std::size_t size) override {
+            m_allocator.Free(ptr, size);
+        }
+
+        virtual void Reset() override {
+            m_allocator.Reset();
+        }
+
+        virtual std::size_t PeakBytes() const override { return m_peak; }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    bool csv = false;
+    std::size_t batch = 4096;
+    std::size_t rounds = 50;
+    unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            maxThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            return CheckGrowableSpikes() ? 0 : 1;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--csv] [--batch N] [--rounds N] [--threads N] [--check]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::pair<std::string, Benchmark::TargetFactory>> targets = {
+        {"malloc", [](unsigned) { return std::make_unique<MallocTarget>(); }},
+        {"PoolAllocator", [batch](unsigned) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<PoolAllocator>(batch * BLOCK_SIZE, BLOCK_SIZE), true, false);
+        }},
+        {"ConcurrentPoolAllocator", [batch](unsigned users) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<ConcurrentPoolAllocator>(users * batch * BLOCK_SIZE, BLOCK_SIZE), true, false, false, true);
+        }},
+        {"ThreadCachePoolAllocator", [batch](unsigned users) {
+            // Room for every thread's live blocks plus a full magazine each
+            return std::make_unique<AllocatorTarget>(std::make_unique<ThreadCachePoolAllocator>(users * (batch + 64) * BLOCK_SIZE, BLOCK_SIZE), true, false, false, true);
+        }},
+        {"ShardedPoolAllocator", [batch](unsigned users) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<ShardedPoolAllocator>(batch * BLOCK_SIZE, BLOCK_SIZE, users), true, false, false, true);
+        }},
+        {"GrowablePoolAllocator", [batch](unsigned) {
+            // Starts at a sixteenth of the batch, so every round grows and releases slabs
+            return std::make_unique<GrowableTarget>(std::max<std::size_t>(batch / 16, 1) * BLOCK_SIZE);
+        }},
+        {"StackAllocator", [batch](unsigned) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<StackAllocator>(batch * (BLOCK_SIZE + 32)), false, true);
+        }},
+        {"FreeListAllocator(first-fit)", [batch](unsigned) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<FreeListAllocator>(batch * (MAX_MIXED_SIZE + 48), FreeListAllocator::PlacementPolicy::FirstFit), false, false);
+        }},
+        {"FreeListAllocator(best-fit)", [batch](unsigned) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<FreeListAllocator>(batch * (MAX_MIXED_SIZE + 48), FreeListAllocator::PlacementPolicy::BestFit), false, false);
+        }},
+        {"BuddyAllocator", [](unsigned) {
+            return std::make_unique<AllocatorTarget>(std::make_unique<BuddyAllocator>(BUDDY_ARENA_SIZE), false, false, true);
+        }},
+        {"LinearAllocator", [batch](unsigned) { return std::make_unique<LinearTarget>(batch * (MAX_MIXED_SIZE + 16)); }},
+        {"Moya::MemoryPool", [](unsigned) { return std::make_unique<MoyaTarget>(); }},
+    };
+    const Workload workloads[] = {Workload::Lifo, Workload::Fifo, Workload::Random, Workload::MixedSizes, Workload::BufferChurn};
+    const unsigned threadCounts[] = {1, maxThreads};
+
+    Benchmark benchmark(BLOCK_SIZE, batch, rounds);
+    if (csv) {
+        Benchmark::WriteCsvHeader(std::cout);
+    }
+    for (const auto& target : targets) {
+        for (const auto workload : workloads) {
+            for (const auto threads : threadCounts) {
+                for (const bool shared : {false, true}) {
+                    BenchmarkResult result;
+                    if ((shared && threads == 1) || !benchmark.Run(target.first, target.second, workload, threads, shared, result)) {
+                        continue;
+                    }
+                    if (csv) {
+                        Benchmark::WriteCsvLine(std::cout, result);
+                    } else {
+                        Benchmark::WriteJsonLine(std::cout, result);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "BuddyAllocator.h"
+#include "Utils.h"  /* CalculatePadding */
+#include <assert.h>
+#include <stdlib.h>     /* malloc, free */
+#include <algorithm>    /* max */
+#include <bit>          /* has_single_bit */
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+BuddyAllocator::BuddyAllocator(const std::size_t totalSize, const std::size_t minBlockSize)
+: Allocator(totalSize) {
+    assert(std::has_single_bit(minBlockSize) && minBlockSize >= sizeof(FreeBlock) && "Min block size must be a power of two that fits a free-list node");
+    assert(std::has_single_bit(totalSize) && totalSize >= minBlockSize && "Total Size must be a power of two not below the min block size");
+    m_minBlockSize = minBlockSize;
+    m_maxOrder = 0;
+    while ((minBlockSize << m_maxOrder) < totalSize) {
+        ++m_maxOrder;
+    }
+    assert(m_maxOrder < 256 && "Too many orders for the order table");
+
+    m_freeLists.resize(m_maxOrder + 1);
+    m_freeBitmaps.resize(m_maxOrder + 1);
+    for (std::size_t order = 0; order <= m_maxOrder; ++order) {
+        const std::size_t blocks = totalSize / (minBlockSize << order);
+        m_freeBitmaps[order].resize((blocks + 63) / 64);
+    }
+    m_allocatedOrder.resize(totalSize / minBlockSize);
+}
+
+void BuddyAllocator::Init() {
+    if (m_raw_ptr != nullptr) {
+        free(m_raw_ptr);
+    }
+    // Align the arena to the smallest block so every block is aligned to it
+    m_raw_ptr = malloc(m_totalSize + m_minBlockSize);
+    const std::size_t rawAddress = reinterpret_cast<std::size_t>(m_raw_ptr);
+    m_start_ptr = static_cast<char*>(m_raw_ptr) + Utils::CalculatePadding(rawAddress, m_minBlockSize) % m_minBlockSize;
+    this->Reset();
+}
+
+BuddyAllocator::~BuddyAllocator() {
+    free(m_raw_ptr);
+    m_raw_ptr = nullptr;
+}
+
+void* BuddyAllocator::Allocate(const std::size_t size, const std::size_t alignment) {
+    // Blocks are only guaranteed the arena's alignment, which is the min block size
+    if (alignment > m_minBlockSize || size > m_totalSize) {
+        return nullptr;
+    }
+
+    const std::size_t order = OrderFor(size);
+    std::size_t available = order;
+    while (available <= m_maxOrder && m_freeLists[available] == nullptr) {
+        ++available;
+    }
+    if (available > m_maxOrder) {
+        return nullptr;
+    }
+
+    const std::size_t offset = reinterpret_cast<char*>(m_freeLists[available]) - m_start_ptr;
+    RemoveFree(offset, available);
+    // Split down, leaving the upper halves free
+    while (available > order) {
+        --available;
+        PushFree(offset + (m_minBlockSize << available), available);
+    }
+
+    m_allocatedOrder[offset / m_minBlockSize] = static_cast<std::uint8_t>(order);
+    m_used += m_minBlockSize << order;
+    m_peak = std::max(m_peak, m_used);
+#ifdef _DEBUG
+    //std::cout << "A" << "\t@O " << offset << "\tK " << order << "\tM " << m_used << std::endl;
+#endif
+
+    return m_start_ptr + offset;
+}
+
+void BuddyAllocator::Free(void* ptr) {
+    std::size_t offset = static_cast<char*>(ptr) - m_start_ptr;
+    assert(offset < m_totalSize && offset % m_minBlockSize == 0 && "Pointer does not belong to this allocator");
+
+    std::size_t order = m_allocatedOrder[offset / m_minBlockSize];
+    m_used -= m_minBlockSize << order;
+
+    // Merge upwards while the buddy is free as a whole block of the same order
+    while (order < m_maxOrder) {
+        const std::size_t buddy = offset ^ (m_minBlockSize << order);
+        if (!IsFree(buddy, order)) {
+            break;
+        }
+        RemoveFree(buddy, order);
+        offset = std::min(offset, buddy);
+        ++order;
+    }
+    PushFree(offset, order);
+#ifdef _DEBUG
+    //std::cout << "F" << "\t@O " << offset << "\tK " << order << "\tM " << m_used << std::endl;
+#endif
+}
+
+void BuddyAllocator::Reset() {
+    m_used = 0;
+    m_peak = 0;
+    std::fill(m_freeLists.begin(), m_freeLists.end(), nullptr);
+    for (auto& bitmap : m_freeBitmaps) {
+        std::fill(bitmap.begin(), bitmap.end(), 0);
+    }
+    PushFree(0, m_maxOrder);
+}
+
+std::size_t BuddyAllocator::FreeBlockCount(const std::size_t order) const {
+    std::size_t count = 0;
+    for (FreeBlock* block = m_freeLists[order]; block != nullptr; block = block->next) {
+        ++count;
+    }
+    return count;
+}
+
+std::size_t BuddyAllocator::OrderFor(const std::size_t size) const {
+    std::size_t order = 0;
+    while ((m_minBlockSize << order) < size) {
+        ++order;
+    }
+    return order;
+}
+
+std::size_t BuddyAllocator::BlockIndex(const std::size_t offset, const std::size_t order) const {
+    return offset / (m_minBlockSize << order);
+}
+
+bool BuddyAllocator::IsFree(const std::size_t offset, const std::size_t order) const {
+    const std::size_t index = BlockIndex(offset, order);
+    return (m_freeBitmaps[order][index / 64] >> (index % 64)) & 1;
+}
+
+void BuddyAllocator::PushFree(const std::size_t offset, const std::size_t order) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(m_start_ptr + offset);
+    block->prev = nullptr;
+    block->next = m_freeLists[order];
+    if (block->next != nullptr) {
+        block->next->prev = block;
+    }
+    m_freeLists[order] = block;
+
+    const std::size_t index = BlockIndex(offset, order);
+    m_freeBitmaps[order][index / 64] |= std::uint64_t(1) << (index % 64);
+}
+
+void BuddyAllocator::RemoveFree(const std::size_t offset, const std::size_t order) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(m_start_ptr + offset);
+    if (block->prev != nullptr) {
+        block->prev->next = block->next;
+    } else {
+        m_freeLists[order] = block->next;
+    }
+    if (block->next != nullptr) {
+        block->next->prev = block->prev;
+    }
+
+    const std::size_t index = BlockIndex(offset, order);
+    m_freeBitmaps[order][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+}
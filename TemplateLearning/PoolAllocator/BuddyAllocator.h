@@ -0,0 +1,55 @@
+#ifndef BUDDYALLOCATOR_H
+#define BUDDYALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdint>
+#include <vector>
+
+// Binary buddy allocator for power-of-two buffers. Order 0 blocks are
+// minBlockSize bytes, order k blocks are minBlockSize << k; totalSize must be a
+// power-of-two multiple of minBlockSize. Allocation splits a larger block down,
+// Free merges with the buddy while it is free: both O(log n) in the number of
+// orders. Each order keeps an intrusive free list plus a bitmap of which of its
+// blocks are free, so finding out whether a buddy is free is a bit test.
+class BuddyAllocator : public Allocator {
+private:
+    struct FreeBlock {
+        FreeBlock* prev;
+        FreeBlock* next;
+    };
+
+    void* m_raw_ptr = nullptr;
+    char* m_start_ptr = nullptr;
+    std::size_t m_minBlockSize;
+    std::size_t m_maxOrder;
+
+    std::vector<FreeBlock*> m_freeLists;
+    std::vector<std::vector<std::uint64_t>> m_freeBitmaps;
+    // Order each allocation was served at, indexed by its first order-0 block
+    std::vector<std::uint8_t> m_allocatedOrder;
+public:
+    BuddyAllocator(const std::size_t totalSize, const std::size_t minBlockSize = 4096);
+
+    virtual ~BuddyAllocator();
+
+    // alignment up to minBlockSize; nullptr for anything above
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    virtual void Reset();
+
+    std::size_t FreeBlockCount(const std::size_t order) const;
+private:
+    BuddyAllocator(BuddyAllocator &buddyAllocator);
+
+    std::size_t OrderFor(const std::size_t size) const;
+    std::size_t BlockIndex(const std::size_t offset, const std::size_t order) const;
+    bool IsFree(const std::size_t offset, const std::size_t order) const;
+    void PushFree(const std::size_t offset, const std::size_t order);
+    void RemoveFree(const std::size_t offset, const std::size_t order);
+};
+
+#endif /* BUDDYALLOCATOR_H */
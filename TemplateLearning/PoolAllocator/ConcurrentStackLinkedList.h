@@ -0,0 +1,67 @@
+#ifndef CONCURRENTSTACKLINKEDLIST_H
+#define CONCURRENTSTACKLINKEDLIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free Treiber stack with a versioned head, drop-in for StackLinkedList.
+// Every successful pop bumps the tag so a head that was popped and pushed back
+// in between (ABA) fails the CAS. Uses a double-width CAS where the platform
+// has one lock-free, otherwise packs the tag into the unused upper pointer bits.
+// GCC never has the former, so there the 16-bit packed tag is the only ABA
+// guard: a CAS stalled across exactly a multiple of 65536 other head updates
+// since its load would go undetected.
+// Nodes must stay mapped while the list is in use (pool chunks do), since pop
+// may read next of a node another thread has just taken.
+template <class T>
+class ConcurrentStackLinkedList {
+public:
+    struct Node {
+        T data;
+        Node* next;
+    };
+
+    static constexpr bool concurrent = true;
+private:
+    struct TaggedHead {
+        Node* node;
+        std::uintptr_t tag;
+    };
+
+    template <bool DoubleWidth, int Dummy = 0>
+    class HeadStorage;
+
+    // False on x86-64 GCC, which never reports 16-byte atomics lock-free, so the packed
+    // head is what usually runs. It assumes nodes live in 48-bit user space, i.e. no
+    // 5-level paging addresses; Pack asserts that no pointer bits get dropped.
+    static constexpr bool doubleWidth = std::atomic<TaggedHead>::is_always_lock_free;
+
+    HeadStorage<doubleWidth> head;
+public:
+    ConcurrentStackLinkedList();
+
+    void push(Node * newNode);
+    Node* pop();
+    // Not safe against concurrent push/pop
+    void clear();
+
+    // Link a pre-chained first..last segment with a single CAS
+    void pushChain(Node * first, Node * last);
+    // Unlink up to count nodes with a single CAS, returns how many were taken.
+    // Under contention it may take fewer while nodes remain; 0 means empty.
+    std::size_t popChain(Node ** out, const std::size_t count);
+
+    // Sets node->next, for callers that pre-chain a segment for pushChain. Every
+    // access to next is atomic, since pop may read it from a node it lost the race for.
+    static void link(Node * node, Node * next);
+private:
+    ConcurrentStackLinkedList(ConcurrentStackLinkedList &concurrentStackLinkedList);
+
+    // next of a node that another thread may already own and be writing
+    static Node* LoadNext(Node * node);
+};
+
+#include "ConcurrentStackLinkedListImpl.h"
+
+#endif /* CONCURRENTSTACKLINKEDLIST_H */
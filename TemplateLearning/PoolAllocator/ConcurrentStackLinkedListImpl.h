@@ -0,0 +1,134 @@
+#include "ConcurrentStackLinkedList.h"
+#include <assert.h>
+
+// {pointer, tag} swapped as one double-width word
+template <class T>
+template <int Dummy>
+class ConcurrentStackLinkedList<T>::HeadStorage<true, Dummy> {
+    std::atomic<TaggedHead> m_value{TaggedHead{nullptr, 0}};
+public:
+    TaggedHead load() const {
+        return m_value.load(std::memory_order_acquire);
+    }
+
+    void store(const TaggedHead desired) {
+        m_value.store(desired, std::memory_order_release);
+    }
+
+    bool compareExchange(TaggedHead& expected, const TaggedHead desired) {
+        return m_value.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+};
+
+// Tag packed into the top 16 bits of a 48-bit user-space pointer
+template <class T>
+template <int Dummy>
+class ConcurrentStackLinkedList<T>::HeadStorage<false, Dummy> {
+    static_assert(sizeof(std::uintptr_t) == 8, "Pointer packing requires 64-bit pointers");
+    static constexpr int pointerBits = 48;
+    static constexpr std::uintptr_t pointerMask = (std::uintptr_t(1) << pointerBits) - 1;
+
+    std::atomic<std::uintptr_t> m_value{0};
+
+    static std::uintptr_t Pack(const TaggedHead head) {
+        assert((reinterpret_cast<std::uintptr_t>(head.node) >> pointerBits) == 0 && "Node address does not fit in 48 bits");
+        return (reinterpret_cast<std::uintptr_t>(head.node) & pointerMask) | (head.tag << pointerBits);
+    }
+
+    static TaggedHead Unpack(const std::uintptr_t value) {
+        return TaggedHead{reinterpret_cast<Node*>(value & pointerMask), value >> pointerBits};
+    }
+public:
+    TaggedHead load() const {
+        return Unpack(m_value.load(std::memory_order_acquire));
+    }
+
+    void store(const TaggedHead desired) {
+        m_value.store(Pack(desired), std::memory_order_release);
+    }
+
+    bool compareExchange(TaggedHead& expected, const TaggedHead desired) {
+        std::uintptr_t packed = Pack(expected);
+        const bool exchanged = m_value.compare_exchange_weak(packed, Pack(desired), std::memory_order_acq_rel, std::memory_order_acquire);
+        expected = Unpack(packed);
+        return exchanged;
+    }
+};
+
+template <class T>
+ConcurrentStackLinkedList<T>::ConcurrentStackLinkedList() {
+
+}
+
+template <class T>
+typename ConcurrentStackLinkedList<T>::Node* ConcurrentStackLinkedList<T>::LoadNext(Node * node) {
+    // Relaxed is enough: a stale value only matters if the head moved, and then the CAS fails
+    return std::atomic_ref<Node*>(node->next).load(std::memory_order_relaxed);
+}
+
+template <class T>
+void ConcurrentStackLinkedList<T>::link(Node * node, Node * next) {
+    std::atomic_ref<Node*>(node->next).store(next, std::memory_order_relaxed);
+}
+
+template <class T>
+void ConcurrentStackLinkedList<T>::push(Node * newNode) {
+    TaggedHead top = head.load();
+    do {
+        link(newNode, top.node);
+    } while (!head.compareExchange(top, TaggedHead{newNode, top.tag + 1}));
+}
+
+template <class T>
+typename ConcurrentStackLinkedList<T>::Node* ConcurrentStackLinkedList<T>::pop() {
+    TaggedHead top = head.load();
+    while (top.node != nullptr) {
+        if (head.compareExchange(top, TaggedHead{LoadNext(top.node), top.tag + 1})) {
+            return top.node;
+        }
+    }
+    return nullptr;
+}
+
+template <class T>
+void ConcurrentStackLinkedList<T>::clear() {
+    const TaggedHead top = head.load();
+    head.store(TaggedHead{nullptr, top.tag + 1});
+}
+
+template <class T>
+void ConcurrentStackLinkedList<T>::pushChain(Node * first, Node * last) {
+    TaggedHead top = head.load();
+    do {
+        link(last, top.node);
+    } while (!head.compareExchange(top, TaggedHead{first, top.tag + 1}));
+}
+
+template <class T>
+std::size_t ConcurrentStackLinkedList<T>::popChain(Node ** out, const std::size_t count) {
+    TaggedHead top = head.load();
+    // Halved after every failed attempt: a long walk needs the head to stay put for
+    // all of it, so under contention it would lose to single pops forever
+    std::size_t target = count;
+    for (;;) {
+        // Walk a snapshot. A popped node may be overwritten by its new owner, so
+        // each link is only followed once the head shows the walk is still intact
+        std::size_t taken = 0;
+        Node * node = top.node;
+        bool intact = true;
+        while (taken < target && node != nullptr) {
+            out[taken++] = node;
+            node = LoadNext(node);
+            const TaggedHead current = head.load();
+            if (current.node != top.node || current.tag != top.tag) {
+                top = current;
+                intact = false;
+                break;
+            }
+        }
+        if (intact && (taken == 0 || head.compareExchange(top, TaggedHead{node, top.tag + 1}))) {
+            return taken;
+        }
+        target = target > 1 ? target / 2 : 1;
+    }
+}
@@ -1,9 +1,15 @@
 #include "PoolAllocator.h"
+#include "ThreadCachePoolAllocator.h"
+#include "SlotMap.h"
+#include "ShardedPoolAllocator.h"
 #include <cstdio>
 #include <ostream>
 #include <iostream>
 #include <windows.h>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
 
 
 #define	MAX_ETHER_FRAME		0x5EA 
@@ -39,43 +45,38 @@ constexpr auto COUNT = 0x186A0;  //100'000
 
 constexpr auto ethSize = sizeof(ETH_REQUEST);
 constexpr auto maxSize = COUNT * ethSize;
-int counter;
+std::atomic<int> counter;
+
+// Writes the packet straight into its destination: no stack INTERMEDIATE_BUFFER
+// or NDISRD_ETH_Packet copies, every byte of the frame is written once
+void fillEth(ETH_REQUEST& eth)
+{
+	eth.hAdapterHandle = reinterpret_cast<void*>(1220);
+	auto& buffer = eth.EthPacket.Buffer;
+	buffer.m_qLink = {};
+	buffer.m_dwDeviceFlags = counter * 0x100;
+	buffer.m_Length = counter * 0x200;
+	buffer.m_Flags = counter * 0x300;
+	buffer.m_8021q = counter * 0x400;
+	buffer.m_FilterID = counter * 0x500;
+	memset(buffer.m_Reserved, 0, sizeof(buffer.m_Reserved));
+	memset(buffer.m_IBuffer, 1, MAX_ETHER_FRAME);
+	++counter;
+}
 
 void* fillEth(const size_t ethSize)
 {
 	auto ethAddr = reinterpret_cast<ETH_REQUEST*>(EthPoolAllocator->Allocate(ethSize, 8));
-
-	ethAddr->hAdapterHandle = reinterpret_cast<void*>(1220);
-	NDISRD_ETH_Packet bfr{};
-	INTERMEDIATE_BUFFER interMedBuffer{};
-	interMedBuffer.m_dwDeviceFlags = counter * 0x100;
-	interMedBuffer.m_Length = counter * 0x200;
-	interMedBuffer.m_Flags = counter * 0x300;
-	interMedBuffer.m_8021q = counter * 0x400;
-	interMedBuffer.m_FilterID = counter * 0x500;
-	interMedBuffer.m_Reserved[4] = {  0x600, };
-	memset(interMedBuffer.m_IBuffer, 1, MAX_ETHER_FRAME);
-	bfr.Buffer = interMedBuffer;
-	ethAddr->EthPacket = bfr;
-	++counter;
+	fillEth(*ethAddr);
 	return static_cast<void*>(ethAddr);
 }
 
-void fillEth(ETH_REQUEST& eth)
+// The pool chunk is the packet: constructed in place, then filled in place
+ETH_REQUEST* emplaceEth(PoolAllocator& pool)
 {
-	eth.hAdapterHandle = reinterpret_cast<void*>(1220);
-	NDISRD_ETH_Packet bfr{};
-	INTERMEDIATE_BUFFER interMedBuffer{};
-	interMedBuffer.m_dwDeviceFlags = counter * 0x100;
-	interMedBuffer.m_Length = counter * 0x200;
-	interMedBuffer.m_Flags = counter * 0x300;
-	interMedBuffer.m_8021q = counter * 0x400;
-	interMedBuffer.m_FilterID = counter * 0x500;
-	interMedBuffer.m_Reserved[4] = { 0x600, };
-	memset(interMedBuffer.m_IBuffer, 1, MAX_ETHER_FRAME);
-	bfr.Buffer = interMedBuffer;
-	eth.EthPacket = bfr;
-	++counter;
+	const auto eth = pool.Emplace<ETH_REQUEST>();
+	fillEth(*eth);
+	return eth;
 }
 
 void freeEth(void* ethAddr)
@@ -87,7 +88,8 @@ int mainAllc()
 {
 	counter = 1;
 
-	EthPoolAllocator = new PoolAllocator(maxSize, ethSize);
+	const auto pool = new PoolAllocator(maxSize, ethSize, VirtualMemory::HugePages);
+	EthPoolAllocator = pool;
 	EthPoolAllocator->Init();
 	for(auto iop = 0 ; iop < 100 ; iop ++)
 	{
@@ -95,7 +97,7 @@ int mainAllc()
 		void* addresses[COUNT];
 		const auto fillStart = std::chrono::high_resolution_clock::now();
 		for (auto& addresse : addresses)
-			addresse = fillEth(ethSize);
+			addresse = emplaceEth(*pool);
 		const auto fillEnd = std::chrono::high_resolution_clock::now();
 
 		const auto iEth = static_cast<ETH_REQUEST*>(addresses[5000]);
@@ -122,6 +124,237 @@ int mainAllc()
 }
 
 
+// Capture threads fill and free through per-thread magazines of one shared pool
+int mainAllcThreaded()
+{
+	constexpr auto THREADS = 4;
+	constexpr auto PER_THREAD = COUNT / THREADS;
+
+	counter = 1;
+
+	EthPoolAllocator = new ThreadCachePoolAllocator(maxSize, ethSize);
+	EthPoolAllocator->Init();
+	for (auto iop = 0; iop < 100; iop++)
+	{
+		std::cout << "__________________ROUND: " << iop << "_________________________" << std::endl;
+		const auto fillStart = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> workers;
+		for (auto t = 0; t < THREADS; t++)
+		{
+			workers.emplace_back([]
+			{
+				std::vector<void*> addresses(PER_THREAD);
+				for (auto& addresse : addresses)
+					addresse = fillEth(ethSize);
+				for (auto& addresse : addresses)
+					freeEth(addresse);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+		const auto fillEnd = std::chrono::high_resolution_clock::now();
+
+		auto time_span = std::chrono::duration_cast<std::chrono::duration<double>>(fillEnd - fillStart);
+		std::cout << "fill+free (" << THREADS << " threads): " << time_span.count() << " seconds." << std::endl;
+
+		Sleep(2000);
+	}
+
+	delete EthPoolAllocator;
+	return getchar();
+}
+
+// Same rounds as mainAllc, but the pool is used through its concrete type (no virtual
+// dispatch) and each round takes and returns all its chunks as one free-list segment
+int mainAllcBatch()
+{
+	counter = 1;
+
+	auto pool = new PoolAllocator(maxSize, ethSize, VirtualMemory::HugePages);
+	pool->Init();
+	for (auto iop = 0; iop < 100; iop++)
+	{
+		std::cout << "__________________ROUND: " << iop << "_________________________" << std::endl;
+		void* addresses[COUNT];
+		const auto fillStart = std::chrono::high_resolution_clock::now();
+		const auto taken = pool->AllocateBatch(COUNT, addresses);
+		for (size_t i = 0; i < taken; i++)
+			fillEth(*static_cast<ETH_REQUEST*>(addresses[i]));
+		const auto fillEnd = std::chrono::high_resolution_clock::now();
+
+		const auto iEth = static_cast<ETH_REQUEST*>(addresses[5000]);
+		const auto iEth1 = static_cast<ETH_REQUEST*>(addresses[2200]);
+		std::cout << "Length is:" << iEth->EthPacket.Buffer.m_Length << " Flags is:" << iEth->EthPacket.Buffer.m_Flags << std::endl;
+		std::cout << "Length is:" << iEth1->EthPacket.Buffer.m_Length << " Flags is:" << iEth1->EthPacket.Buffer.m_Flags << std::endl;
+
+		const auto freeStart = std::chrono::high_resolution_clock::now();
+		pool->FreeBatch(addresses, taken);
+		const auto freeEnd = std::chrono::high_resolution_clock::now();
+
+		auto fill_time_span = std::chrono::duration_cast<std::chrono::duration<double>>(fillEnd - fillStart);
+		auto free_time_span = std::chrono::duration_cast<std::chrono::duration<double>>(freeEnd - freeStart);
+
+		std::cout << "fill: " << fill_time_span.count() << " seconds." << std::endl;
+		std::cout << "free: " << free_time_span.count() << " seconds." << std::endl;
+
+		Sleep(2000);
+	}
+
+	delete pool;
+	return getchar();
+}
+
+// Single-producer/single-consumer hand-off between a capture and a processing thread
+struct PacketRing
+{
+	static constexpr size_t SIZE = 1024;
+	void* slots[SIZE];
+	alignas(64) std::atomic<size_t> head{ 0 };
+	alignas(64) std::atomic<size_t> tail{ 0 };
+
+	bool push(void* packet)
+	{
+		const auto t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == SIZE)
+			return false;
+		slots[t % SIZE] = packet;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(void*& packet)
+	{
+		const auto h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+		packet = slots[h % SIZE];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+// Producers fill packets from EthPoolAllocator, consumers read and free them:
+// every free happens on a different thread than the allocation
+double runProducerConsumer(const int pairs)
+{
+	const auto perPair = COUNT / pairs;
+	std::vector<std::unique_ptr<PacketRing>> rings;
+	for (auto p = 0; p < pairs; p++)
+		rings.push_back(std::make_unique<PacketRing>());
+
+	std::atomic<unsigned long long> totalLength{ 0 };
+	const auto start = std::chrono::high_resolution_clock::now();
+	std::vector<std::thread> workers;
+	for (auto p = 0; p < pairs; p++)
+	{
+		auto& ring = *rings[p];
+		workers.emplace_back([&ring, perPair]
+		{
+			for (auto i = 0; i < perPair; i++)
+			{
+				const auto packet = fillEth(ethSize);
+				while (!ring.push(packet))
+					std::this_thread::yield();
+			}
+		});
+		workers.emplace_back([&ring, perPair, &totalLength]
+		{
+			unsigned long long length = 0;
+			for (auto i = 0; i < perPair; i++)
+			{
+				void* packet;
+				while (!ring.pop(packet))
+					std::this_thread::yield();
+				length += static_cast<ETH_REQUEST*>(packet)->EthPacket.Buffer.m_Length;
+				freeEth(packet);
+			}
+			totalLength += length;
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+	const auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "Total length:" << totalLength << std::endl;
+	return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+}
+
+// Cross-thread frees: one shared lock-free pool against per-thread shards with remote-free lists
+int mainAllcProducerConsumer()
+{
+	constexpr auto PAIRS = 2;
+
+	counter = 1;
+
+	const auto shared = new ConcurrentPoolAllocator(maxSize, ethSize);
+	shared->Init();
+	const auto sharded = new ShardedPoolAllocator(maxSize, ethSize, PAIRS);
+	sharded->Init();
+	for (auto iop = 0; iop < 100; iop++)
+	{
+		std::cout << "__________________ROUND: " << iop << "_________________________" << std::endl;
+		EthPoolAllocator = shared;
+		const auto sharedTime = runProducerConsumer(PAIRS);
+		EthPoolAllocator = sharded;
+		const auto shardedTime = runProducerConsumer(PAIRS);
+
+		std::cout << "shared pool: " << sharedTime << " seconds." << std::endl;
+		std::cout << "sharded pool: " << shardedTime << " seconds." << std::endl;
+
+		Sleep(2000);
+	}
+
+	delete sharded;
+	delete shared;
+	return getchar();
+}
+
+// Packet table keyed by generational handles: fill, walk the live packets densely,
+// drop every other one and check that the dropped handles no longer resolve
+int mainPacketTable()
+{
+	counter = 1;
+
+	auto table = new SlotMap<ETH_REQUEST>(COUNT, VirtualMemory::HugePages);
+	std::vector<SlotHandle> handles(COUNT);
+	for (auto iop = 0; iop < 100; iop++)
+	{
+		std::cout << "__________________ROUND: " << iop << "_________________________" << std::endl;
+		const auto fillStart = std::chrono::high_resolution_clock::now();
+		for (auto& handle : handles)
+		{
+			handle = table->Insert();
+			fillEth(*table->Get(handle));
+		}
+		const auto fillEnd = std::chrono::high_resolution_clock::now();
+
+		unsigned long long totalLength = 0;
+		for (const auto& eth : *table)
+			totalLength += eth.EthPacket.Buffer.m_Length;
+		const auto walkEnd = std::chrono::high_resolution_clock::now();
+
+		for (size_t i = 0; i < handles.size(); i += 2)
+			table->Erase(handles[i]);
+		const auto stale = table->Get(handles[0]) == nullptr;
+		table->Clear();
+		const auto freeEnd = std::chrono::high_resolution_clock::now();
+
+		auto fill_time_span = std::chrono::duration_cast<std::chrono::duration<double>>(fillEnd - fillStart);
+		auto walk_time_span = std::chrono::duration_cast<std::chrono::duration<double>>(walkEnd - fillEnd);
+		auto free_time_span = std::chrono::duration_cast<std::chrono::duration<double>>(freeEnd - walkEnd);
+
+		std::cout << "Total length:" << totalLength << " stale handle rejected:" << stale << std::endl;
+		std::cout << "fill: " << fill_time_span.count() << " seconds." << std::endl;
+		std::cout << "walk: " << walk_time_span.count() << " seconds." << std::endl;
+		std::cout << "free: " << free_time_span.count() << " seconds." << std::endl;
+
+		Sleep(2000);
+	}
+
+	delete table;
+	return getchar();
+}
+
 int mainNew()
 {
 	ETH_REQUEST* addresses[COUNT]={};
@@ -0,0 +1,246 @@
+#include "FreeListAllocator.h"
+#include <assert.h>
+#include <stdlib.h>     /* malloc, free */
+#include <algorithm>    /* max */
+#include <bit>          /* has_single_bit */
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+namespace {
+    constexpr std::size_t BLOCK_ALIGNMENT = 16;
+    constexpr std::size_t FOOTER_SIZE = sizeof(std::size_t);
+}
+
+FreeListAllocator::FreeListAllocator(const std::size_t totalSize, const PlacementPolicy policy)
+: Allocator(totalSize) {
+    static_assert(sizeof(BlockHeader) % BLOCK_ALIGNMENT == 0, "Header must keep payloads aligned");
+    assert(totalSize % BLOCK_ALIGNMENT == 0 && "Total Size must be a multiple of 16");
+    m_policy = policy;
+}
+
+void FreeListAllocator::Init() {
+    if (m_start_ptr != nullptr) {
+        free(m_start_ptr);
+    }
+    m_start_ptr = malloc(m_totalSize);
+    this->Reset();
+}
+
+FreeListAllocator::~FreeListAllocator() {
+    free(m_start_ptr);
+    m_start_ptr = nullptr;
+}
+
+void* FreeListAllocator::Allocate(const std::size_t size, const std::size_t alignment) {
+    assert((alignment == 0 || std::has_single_bit(alignment)) && "Alignment must be a power of two");
+
+    const std::size_t minBlock = sizeof(BlockHeader) + sizeof(FreeLinks) + FOOTER_SIZE;
+    const std::size_t roundedMin = (minBlock + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+    std::size_t needed = sizeof(BlockHeader) + size + FOOTER_SIZE;
+    needed = (std::max(needed, minBlock) + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+
+    // Payloads are 16-aligned; a larger alignment may skip up to alignment bytes,
+    // plus a minimum block when the skipped front is too small to stand alone
+    const bool overAligned = alignment > BLOCK_ALIGNMENT;
+    BlockHeader* block = FindFree(overAligned ? needed + alignment + roundedMin : needed);
+    if (block == nullptr) {
+        return nullptr;
+    }
+    RemoveFree(block);
+
+    if (overAligned) {
+        const std::uintptr_t payload = reinterpret_cast<std::uintptr_t>(block + 1);
+        std::uintptr_t aligned = (payload + alignment - 1) & ~(alignment - 1);
+        if (aligned != payload && aligned - payload < roundedMin) {
+            aligned = (payload + roundedMin + alignment - 1) & ~(alignment - 1);
+        }
+        const std::size_t front = aligned - payload;
+        if (front != 0) {
+            // The block came off the free list, so its neighbours are allocated and the front needs no merging
+            const std::size_t total = BlockSize(block);
+            WriteTags(block, front, false);
+            InsertFree(block);
+            block = reinterpret_cast<BlockHeader*>(reinterpret_cast<char*>(block) + front);
+            WriteTags(block, total - front, false);
+        }
+    }
+
+    // Split off the tail if it can stand as a block of its own
+    const std::size_t blockSize = BlockSize(block);
+    if (blockSize - needed >= roundedMin) {
+        BlockHeader* rest = reinterpret_cast<BlockHeader*>(reinterpret_cast<char*>(block) + needed);
+        WriteTags(rest, blockSize - needed, false);
+        InsertFree(rest);
+        WriteTags(block, needed, true);
+    } else {
+        WriteTags(block, blockSize, true);
+    }
+    block->requested = size;
+
+    m_used += BlockSize(block);
+    m_requested += size;
+    m_peak = std::max(m_peak, m_used);
+#ifdef _DEBUG
+    //std::cout << "A" << "\t@B " << (void*) block << "\tS " << BlockSize(block) << "\tM " << m_used << std::endl;
+#endif
+
+    return static_cast<void*>(block + 1);
+}
+
+void FreeListAllocator::Free(void* ptr) {
+    BlockHeader* block = static_cast<BlockHeader*>(ptr) - 1;
+    assert(IsAllocated(block) && "Double free or foreign pointer");
+
+    std::size_t size = BlockSize(block);
+    m_used -= size;
+    m_requested -= block->requested;
+
+    char* const start = static_cast<char*>(m_start_ptr);
+    char* const end = start + m_totalSize;
+
+    // Merge with the following block
+    BlockHeader* next = reinterpret_cast<BlockHeader*>(reinterpret_cast<char*>(block) + size);
+    if (reinterpret_cast<char*>(next) < end && !IsAllocated(next)) {
+        RemoveFree(next);
+        size += BlockSize(next);
+    }
+
+    // Merge with the preceding block, found through its footer
+    if (reinterpret_cast<char*>(block) > start) {
+        const std::size_t prevTag = *reinterpret_cast<std::size_t*>(reinterpret_cast<char*>(block) - FOOTER_SIZE);
+        if ((prevTag & 1) == 0) {
+            BlockHeader* prev = reinterpret_cast<BlockHeader*>(reinterpret_cast<char*>(block) - prevTag);
+            RemoveFree(prev);
+            size += prevTag;
+            block = prev;
+        }
+    }
+
+    WriteTags(block, size, false);
+    InsertFree(block);
+#ifdef _DEBUG
+    //std::cout << "F" << "\t@B " << (void*) block << "\tS " << size << "\tM " << m_used << std::endl;
+#endif
+}
+
+void FreeListAllocator::Reset() {
+    m_used = 0;
+    m_peak = 0;
+    m_requested = 0;
+    m_freeBlocks = 0;
+    m_nonEmptyBins = 0;
+    std::fill(m_bins, m_bins + BIN_COUNT, nullptr);
+
+    BlockHeader* first = static_cast<BlockHeader*>(m_start_ptr);
+    WriteTags(first, m_totalSize, false);
+    InsertFree(first);
+}
+
+std::size_t FreeListAllocator::LargestFreeBlock() const {
+    if (m_nonEmptyBins == 0) {
+        return 0;
+    }
+    std::size_t bin = BIN_COUNT - 1;
+    while ((m_nonEmptyBins & (std::uint64_t(1) << bin)) == 0) {
+        --bin;
+    }
+    std::size_t largest = 0;
+    for (BlockHeader* block = m_bins[bin]; block != nullptr; block = Links(block)->next) {
+        largest = std::max(largest, BlockSize(block));
+    }
+    return largest;
+}
+
+double FreeListAllocator::Fragmentation() const {
+    const std::size_t freeBytes = m_totalSize - m_used;
+    return freeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(LargestFreeBlock()) / freeBytes;
+}
+
+double FreeListAllocator::Overhead() const {
+    return m_used == 0 ? 0.0 : 1.0 - static_cast<double>(m_requested) / m_used;
+}
+
+void FreeListAllocator::WriteTags(BlockHeader* block, const std::size_t size, const bool allocated) {
+    const std::size_t tag = size | (allocated ? 1 : 0);
+    block->size = tag;
+    block->requested = 0;
+    *reinterpret_cast<std::size_t*>(reinterpret_cast<char*>(block) + size - FOOTER_SIZE) = tag;
+}
+
+std::size_t FreeListAllocator::BinIndex(const std::size_t size) {
+    std::size_t bin = 0;
+    while ((size >> (bin + 1)) != 0 && bin + 1 < BIN_COUNT) {
+        ++bin;
+    }
+    return bin;
+}
+
+void FreeListAllocator::InsertFree(BlockHeader* block) {
+    const std::size_t bin = BinIndex(BlockSize(block));
+    FreeLinks* links = Links(block);
+    links->prev = nullptr;
+    links->next = m_bins[bin];
+    if (m_bins[bin] != nullptr) {
+        Links(m_bins[bin])->prev = block;
+    }
+    m_bins[bin] = block;
+    m_nonEmptyBins |= std::uint64_t(1) << bin;
+    ++m_freeBlocks;
+}
+
+void FreeListAllocator::RemoveFree(BlockHeader* block) {
+    const std::size_t bin = BinIndex(BlockSize(block));
+    FreeLinks* links = Links(block);
+    if (links->prev != nullptr) {
+        Links(links->prev)->next = links->next;
+    } else {
+        m_bins[bin] = links->next;
+    }
+    if (links->next != nullptr) {
+        Links(links->next)->prev = links->prev;
+    }
+    if (m_bins[bin] == nullptr) {
+        m_nonEmptyBins &= ~(std::uint64_t(1) << bin);
+    }
+    --m_freeBlocks;
+}
+
+FreeListAllocator::BlockHeader* FreeListAllocator::FindFree(const std::size_t size) const {
+    // The request's own bin may hold blocks that are too small; later bins never do
+    std::size_t bin = BinIndex(size);
+    BlockHeader* best = nullptr;
+    for (BlockHeader* block = m_bins[bin]; block != nullptr; block = Links(block)->next) {
+        const std::size_t blockSize = BlockSize(block);
+        if (blockSize < size) {
+            continue;
+        }
+        if (m_policy == PlacementPolicy::FirstFit) {
+            return block;
+        }
+        if (best == nullptr || blockSize < BlockSize(best)) {
+            best = block;
+        }
+    }
+    if (best != nullptr) {
+        return best;
+    }
+
+    const std::uint64_t higherBins = bin + 1 < BIN_COUNT ? m_nonEmptyBins & (~std::uint64_t(0) << (bin + 1)) : 0;
+    if (higherBins == 0) {
+        return nullptr;
+    }
+    std::size_t nextBin = bin + 1;
+    while ((higherBins & (std::uint64_t(1) << nextBin)) == 0) {
+        ++nextBin;
+    }
+    if (m_policy == PlacementPolicy::FirstFit) {
+        return m_bins[nextBin];
+    }
+    for (BlockHeader* block = m_bins[nextBin]; block != nullptr; block = Links(block)->next) {
+        if (best == nullptr || BlockSize(block) < BlockSize(best)) {
+            best = block;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,77 @@
+#ifndef FREELISTALLOCATOR_H
+#define FREELISTALLOCATOR_H
+
+#include "Allocator.h"
+#include <cstdint>
+
+// General-purpose variable-size allocator over one fixed block, any free order.
+// Blocks carry boundary tags (size in header and footer) so a freed block is
+// merged with free neighbours immediately. Free blocks sit in segregated
+// power-of-two bins; a bitmap of non-empty bins finds the next candidate bin.
+// m_used counts bytes of allocated blocks including tags, so
+// m_totalSize - m_used is the free space Fragmentation() is measured against.
+class FreeListAllocator : public Allocator {
+public:
+    enum class PlacementPolicy {
+        FirstFit,   // first block in the smallest bin that can hold the request
+        BestFit     // smallest block that can hold the request
+    };
+private:
+    struct BlockHeader {
+        std::size_t size;       // block size including tags, bit 0 set while allocated
+        std::size_t requested;  // payload bytes asked for, 0 while free
+    };
+
+    struct FreeLinks {
+        BlockHeader* prev;
+        BlockHeader* next;
+    };
+
+    static constexpr std::size_t BIN_COUNT = 64;
+
+    void* m_start_ptr = nullptr;
+    PlacementPolicy m_policy;
+    BlockHeader* m_bins[BIN_COUNT];
+    std::uint64_t m_nonEmptyBins;
+    std::size_t m_freeBlocks;
+    std::size_t m_requested;
+public:
+    FreeListAllocator(const std::size_t totalSize, const PlacementPolicy policy = PlacementPolicy::BestFit);
+
+    virtual ~FreeListAllocator();
+
+    // Any power-of-two alignment. Above 16 bytes the search asks for enough extra
+    // room to move the payload up to the alignment; the skipped front is split
+    // off as a free block of its own.
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    virtual void Reset();
+
+    std::size_t FreeBlockCount() const { return m_freeBlocks; }
+
+    std::size_t LargestFreeBlock() const;
+
+    // 1 - largest free block / total free bytes: 0 when all free space is contiguous
+    double Fragmentation() const;
+
+    // Tag and rounding overhead of the live allocations, relative to m_used
+    double Overhead() const;
+private:
+    FreeListAllocator(FreeListAllocator &freeListAllocator);
+
+    static std::size_t BlockSize(const BlockHeader* block) { return block->size & ~std::size_t(1); }
+    static bool IsAllocated(const BlockHeader* block) { return (block->size & 1) != 0; }
+    static FreeLinks* Links(BlockHeader* block) { return reinterpret_cast<FreeLinks*>(block + 1); }
+
+    void WriteTags(BlockHeader* block, const std::size_t size, const bool allocated);
+    static std::size_t BinIndex(const std::size_t size);
+    void InsertFree(BlockHeader* block);
+    void RemoveFree(BlockHeader* block);
+    BlockHeader* FindFree(const std::size_t size) const;
+};
+
+#endif /* FREELISTALLOCATOR_H */
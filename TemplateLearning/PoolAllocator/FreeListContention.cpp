@@ -0,0 +1,79 @@
+#include "StackLinkedList.h"
+#include "ConcurrentStackLinkedList.h"
+#include <cstdio>
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Contention benchmark: lock-free ConcurrentStackLinkedList against a
+// StackLinkedList behind a std::mutex, 1 to 64 threads hammering one list.
+
+namespace {
+    struct Payload {
+        char bytes[56];
+    };
+
+    template <class T>
+    class LockedStackLinkedList {
+        StackLinkedList<T> m_list;
+        std::mutex m_mutex;
+    public:
+        using Node = typename StackLinkedList<T>::Node;
+
+        void push(Node* newNode) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_list.push(newNode);
+        }
+
+        Node* pop() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_list.pop();
+        }
+    };
+
+    constexpr auto NODES_PER_THREAD = 64;
+    constexpr auto OPS_PER_THREAD = 200'000;
+
+    // Returns million pop+push pairs per second
+    template <class List>
+    double runContention(const int threadCount) {
+        using Node = typename List::Node;
+        List list;
+        std::vector<Node> nodes(threadCount * NODES_PER_THREAD);
+        for (auto& node : nodes)
+            list.push(&node);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> workers;
+        for (auto t = 0; t < threadCount; ++t) {
+            workers.emplace_back([&list] {
+                Node* held[NODES_PER_THREAD / 2];
+                for (auto op = 0; op < OPS_PER_THREAD; op += NODES_PER_THREAD / 2) {
+                    for (auto& node : held)
+                        node = list.pop();
+                    for (auto& node : held)
+                        list.push(node);
+                }
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+        return threadCount * static_cast<double>(OPS_PER_THREAD) / seconds / 1e6;
+    }
+}
+
+int mainFreeListContention()
+{
+    std::cout << "threads\tlock-free Mops/s\tmutex Mops/s" << std::endl;
+    for (auto threads = 1; threads <= 64; threads *= 2) {
+        const auto lockFree = runContention<ConcurrentStackLinkedList<Payload>>(threads);
+        const auto locked = runContention<LockedStackLinkedList<Payload>>(threads);
+        std::cout << threads << "\t" << lockFree << "\t" << locked << std::endl;
+    }
+    return getchar();
+}
@@ -0,0 +1,10 @@
+// Linux entry point of the free-list contention benchmark in FreeListContention.cpp
+//   freelist_contention
+
+int mainFreeListContention();
+
+int main()
+{
+    mainFreeListContention();
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "GrowablePoolAllocator.h"
+#include <assert.h>
+#include <stdlib.h>     /* malloc, free */
+#include <algorithm>    //max, min
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+GrowablePoolAllocator::GrowablePoolAllocator(const std::size_t initialSize, const std::size_t chunkSize, const std::size_t maxSize,
+                                             const float growthFactor, const std::size_t highWaterMark)
+: Allocator(0) {
+    assert(chunkSize >= sizeof(Node) && "Chunk size must be able to hold a free-list node");
+    assert(initialSize % chunkSize == 0 && initialSize > 0 && "Initial Size must be a non-zero multiple of Chunk Size");
+    assert((maxSize == 0 || maxSize >= initialSize) && "Max Size must not be below Initial Size");
+    assert(growthFactor >= 1.0f && "Growth factor must be at least 1");
+    m_chunkSize = chunkSize;
+    m_initialSize = initialSize;
+    m_maxSize = maxSize;
+    m_growthFactor = growthFactor;
+    m_highWaterMark = std::max(highWaterMark, initialSize);
+    m_peak = 0;
+}
+
+void GrowablePoolAllocator::Init() {
+    ReleaseAll();
+    m_used = 0;
+    m_peak = 0;
+    AddSlab(m_initialSize);
+}
+
+GrowablePoolAllocator::~GrowablePoolAllocator() {
+    ReleaseAll();
+}
+
+void *GrowablePoolAllocator::Allocate(const std::size_t allocationSize, const std::size_t alignment) {
+    assert(allocationSize == this->m_chunkSize && "Allocation size must be equal to chunk size");
+
+    Slab* slab = m_partialSlabs;
+    if (slab == nullptr) {
+        // Grow what is reserved now rather than the last slab, so a spike that was
+        // released again does not make every later slab bigger
+        std::size_t slabSize = std::max(m_initialSize, static_cast<std::size_t>(m_totalSize * (m_growthFactor - 1.0f)));
+        if (m_maxSize != 0) {
+            slabSize = std::min(slabSize, m_maxSize - m_totalSize);
+        }
+        slabSize -= slabSize % m_chunkSize;
+        if (slabSize == 0) {
+            assert(false && "The pool allocator reached its maximum size");
+            return nullptr;
+        }
+        slab = AddSlab(slabSize);
+    }
+
+    Node * freePosition = slab->freeList.pop();
+    if (++slab->liveCount == slab->chunkCount) {
+        UnlinkPartial(slab);
+    }
+
+    m_used += m_chunkSize;
+    m_peak = std::max(m_peak, m_used);
+#ifdef _DEBUG
+    //std::cout << "A" << "\t@S " << (void*) slab->start << "\t@R " << (void*) freePosition << "\tM " << m_used << std::endl;
+#endif
+
+    return static_cast<void*>(freePosition);
+}
+
+void GrowablePoolAllocator::Free(void * ptr) {
+    Slab* slab = FindSlab(ptr);
+    assert(slab != nullptr && "Pointer does not belong to this pool");
+
+    m_used -= m_chunkSize;
+    slab->freeList.push(static_cast<Node *>(ptr));
+    --slab->liveCount;
+
+    if (!slab->inPartialList) {
+        LinkPartial(slab);
+    }
+    // Give fully-empty slabs back as long as we stay at or above the high-water mark
+    if (slab->liveCount == 0 && m_totalSize - slab->chunkCount * m_chunkSize >= m_highWaterMark) {
+        ReleaseSlab(slab);
+    }
+}
+
+void GrowablePoolAllocator::Reset() {
+    Init();
+}
+
+GrowablePoolAllocator::Slab* GrowablePoolAllocator::AddSlab(const std::size_t slabSize) {
+    Slab* slab = new Slab{};
+    slab->start = static_cast<char*>(malloc(slabSize));
+    assert(slab->start != nullptr && "Out of memory while growing the pool");
+    slab->chunkCount = slabSize / m_chunkSize;
+    slab->liveCount = 0;
+
+    // Push in reverse so chunks are handed out in address order
+    for (std::size_t i = slab->chunkCount; i-- > 0;) {
+        slab->freeList.push(reinterpret_cast<Node *>(slab->start + i * m_chunkSize));
+    }
+
+    m_slabs.emplace(reinterpret_cast<std::size_t>(slab->start), slab);
+    LinkPartial(slab);
+    m_totalSize += slabSize;
+    return slab;
+}
+
+void GrowablePoolAllocator::ReleaseSlab(Slab* slab) {
+    if (slab->inPartialList) {
+        UnlinkPartial(slab);
+    }
+    m_slabs.erase(reinterpret_cast<std::size_t>(slab->start));
+    m_totalSize -= slab->chunkCount * m_chunkSize;
+    free(slab->start);
+    delete slab;
+}
+
+void GrowablePoolAllocator::ReleaseAll() {
+    while (!m_slabs.empty()) {
+        ReleaseSlab(m_slabs.begin()->second);
+    }
+}
+
+GrowablePoolAllocator::Slab* GrowablePoolAllocator::FindSlab(void* ptr) const {
+    const std::size_t address = reinterpret_cast<std::size_t>(ptr);
+    auto it = m_slabs.upper_bound(address);
+    if (it == m_slabs.begin()) {
+        return nullptr;
+    }
+    Slab* slab = (--it)->second;
+    return address < it->first + slab->chunkCount * m_chunkSize ? slab : nullptr;
+}
+
+void GrowablePoolAllocator::LinkPartial(Slab* slab) {
+    slab->prevPartial = nullptr;
+    slab->nextPartial = m_partialSlabs;
+    if (m_partialSlabs != nullptr) {
+        m_partialSlabs->prevPartial = slab;
+    }
+    m_partialSlabs = slab;
+    slab->inPartialList = true;
+}
+
+void GrowablePoolAllocator::UnlinkPartial(Slab* slab) {
+    if (slab->prevPartial != nullptr) {
+        slab->prevPartial->nextPartial = slab->nextPartial;
+    } else {
+        m_partialSlabs = slab->nextPartial;
+    }
+    if (slab->nextPartial != nullptr) {
+        slab->nextPartial->prevPartial = slab->prevPartial;
+    }
+    slab->prevPartial = slab->nextPartial = nullptr;
+    slab->inPartialList = false;
+}
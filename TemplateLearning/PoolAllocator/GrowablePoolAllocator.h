@@ -0,0 +1,71 @@
+#ifndef GROWABLEPOOLALLOCATOR_H
+#define GROWABLEPOOLALLOCATOR_H
+
+#include "Allocator.h"
+#include "StackLinkedList.h"
+#include <map>
+
+// Fixed-chunk pool that chains new slabs on demand instead of asserting when
+// full. Each new slab grows the reserved memory growthFactor times (never by
+// less than initialSize), total reserved memory never exceeds maxSize, and
+// slabs that become completely free are returned to the system as long as
+// highWaterMark bytes stay reserved.
+class GrowablePoolAllocator : public Allocator {
+private:
+    struct  FreeHeader{
+    };
+
+    using Node = StackLinkedList<FreeHeader>::Node;
+
+    struct Slab {
+        char* start;
+        std::size_t chunkCount;
+        std::size_t liveCount;
+        StackLinkedList<FreeHeader> freeList;
+        // Intrusive list of slabs that still have free chunks
+        Slab* prevPartial;
+        Slab* nextPartial;
+        bool inPartialList;
+    };
+
+    std::size_t m_chunkSize;
+    std::size_t m_initialSize;
+    std::size_t m_maxSize;
+    std::size_t m_highWaterMark;
+    float m_growthFactor;
+
+    // Slabs keyed by start address, used to find the owner of a freed chunk
+    std::map<std::size_t, Slab*> m_slabs;
+    Slab* m_partialSlabs = nullptr;
+public:
+    // maxSize == 0 means no cap, highWaterMark == 0 keeps the initial size reserved
+    GrowablePoolAllocator(const std::size_t initialSize, const std::size_t chunkSize, const std::size_t maxSize = 0,
+                          const float growthFactor = 2.0f, const std::size_t highWaterMark = 0);
+
+    virtual ~GrowablePoolAllocator();
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    virtual void Reset();
+
+    std::size_t SlabCount() const { return m_slabs.size(); }
+
+    // Bytes currently held in slabs, live or not
+    std::size_t ReservedSize() const { return m_totalSize; }
+private:
+    GrowablePoolAllocator(GrowablePoolAllocator &growablePoolAllocator);
+
+    Slab* AddSlab(const std::size_t slabSize);
+    void ReleaseSlab(Slab* slab);
+    void ReleaseAll();
+    Slab* FindSlab(void* ptr) const;
+
+    void LinkPartial(Slab* slab);
+    void UnlinkPartial(Slab* slab);
+};
+
+#endif /* GROWABLEPOOLALLOCATOR_H */
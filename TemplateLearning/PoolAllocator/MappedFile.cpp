@@ -0,0 +1,172 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    if (!Map()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Resize(const std::size_t size) {
+    // A file cannot be resized while a view of it is mapped
+    Unmap();
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(m_file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file)) {
+        Map();
+        return false;
+    }
+    m_size = size;
+    return Map();
+}
+
+void MappedFile::Flush() {
+    if (m_data != nullptr) {
+        FlushViewOfFile(m_data, m_size);
+        FlushFileBuffers(m_file);
+    }
+}
+
+void MappedFile::Close() {
+    Unmap();
+    if (m_file != nullptr) {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+    m_size = 0;
+}
+
+bool MappedFile::IsOpen() const {
+    return m_file != nullptr;
+}
+
+bool MappedFile::Map() {
+    if (m_size == 0) {
+        return true;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (m_mapping == nullptr) {
+        return false;
+    }
+    m_data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_size);
+    return m_data != nullptr;
+}
+
+void MappedFile::Unmap() {
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (!Map()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Resize(const std::size_t size) {
+    if (ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+#ifdef MREMAP_MAYMOVE
+    if (m_data != nullptr && size != 0) {
+        void* moved = mremap(m_data, m_size, size, MREMAP_MAYMOVE);
+        if (moved != MAP_FAILED) {
+            m_data = moved;
+            m_size = size;
+            return true;
+        }
+    }
+#endif
+    Unmap();
+    m_size = size;
+    return Map();
+}
+
+void MappedFile::Flush() {
+    if (m_data != nullptr) {
+        msync(m_data, m_size, MS_SYNC);
+    }
+}
+
+void MappedFile::Close() {
+    Unmap();
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+}
+
+bool MappedFile::IsOpen() const {
+    return m_fd >= 0;
+}
+
+bool MappedFile::Map() {
+    if (m_size == 0) {
+        return true;
+    }
+    void* ptr = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+    m_data = ptr;
+    return true;
+}
+
+void MappedFile::Unmap() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef> // size_t
+#include <string>
+
+// A whole file mapped read-write and shared, so writes through Data() land in
+// the file (mmap / MapViewOfFile). Resizing remaps it and may move Data().
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens path, creating an empty file if there is none, and maps all of it
+    bool Open(const std::string& path);
+
+    // Sets the file length (new bytes read as zero) and remaps it
+    bool Resize(const std::size_t size);
+
+    // Writes dirty pages back to the file before returning
+    void Flush();
+
+    void Close();
+
+    bool IsOpen() const;
+
+    void* Data() const { return m_data; }
+
+    std::size_t Size() const { return m_size; }
+private:
+    void Unmap();
+    bool Map();
+
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+#endif /* MAPPEDFILE_H */
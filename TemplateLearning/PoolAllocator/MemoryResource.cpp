@@ -0,0 +1,69 @@
+#include "MemoryResource.h"
+#include <cstdint>  /* uintptr_t */
+#include <new>      /* bad_alloc */
+
+AllocatorResource::AllocatorResource(Allocator* allocator, const std::size_t chunkSize)
+: m_allocator(allocator)
+, m_chunkSize(chunkSize) {
+
+}
+
+void* AllocatorResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (m_chunkSize != 0) {
+        if (bytes > m_chunkSize) {
+            throw std::bad_alloc();
+        }
+        bytes = m_chunkSize;
+    }
+
+    void* ptr = m_allocator->Allocate(bytes, alignment);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    if (reinterpret_cast<std::uintptr_t>(ptr) % alignment != 0) {
+        m_allocator->Free(ptr);
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void AllocatorResource::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) {
+    m_allocator->Free(ptr);
+}
+
+bool AllocatorResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    const AllocatorResource* resource = dynamic_cast<const AllocatorResource*>(&other);
+    return resource != nullptr && resource->m_allocator == m_allocator;
+}
+
+StackScratchResource::StackScratchResource(StackAllocator* stack, std::pmr::memory_resource* upstream)
+: m_stack(stack)
+, m_marker(stack->GetMarker())
+, m_overflow(upstream) {
+
+}
+
+StackScratchResource::~StackScratchResource() {
+    release();
+}
+
+void StackScratchResource::release() {
+    m_stack->FreeToMarker(m_marker);
+    m_overflow.release();
+}
+
+void* StackScratchResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void* ptr = m_stack->Allocate(bytes, alignment);
+    if (ptr == nullptr) {
+        ptr = m_overflow.allocate(bytes, alignment);
+    }
+    return ptr;
+}
+
+void StackScratchResource::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) {
+    // Monotonic: memory comes back on release()
+}
+
+bool StackScratchResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
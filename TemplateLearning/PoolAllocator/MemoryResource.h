@@ -0,0 +1,54 @@
+#ifndef MEMORYRESOURCE_H
+#define MEMORYRESOURCE_H
+
+#include "Allocator.h"
+#include "StackAllocator.h"
+#include <memory_resource>
+
+// std::pmr face of the Allocator hierarchy, so std::pmr containers can take
+// their memory from our arenas. Requests the wrapped allocator cannot honour
+// throw std::bad_alloc: a null block, a block that comes back misaligned for
+// the requested alignment, or (for a fixed-chunk pool, chunkSize != 0) more
+// bytes than a chunk holds. Over-aligned requests go to the allocator, which
+// serves them where it can. Smaller requests to a fixed-chunk pool take a
+// whole chunk.
+class AllocatorResource : public std::pmr::memory_resource {
+    Allocator* m_allocator;
+    std::size_t m_chunkSize;
+public:
+    explicit AllocatorResource(Allocator* allocator, const std::size_t chunkSize = 0);
+
+    Allocator* GetAllocator() const { return m_allocator; }
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    virtual void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Monotonic scratch resource over a StackAllocator: deallocate is a no-op and
+// everything handed out since construction (or the last release) goes back in
+// one FreeToMarker. Falls back to upstream once the stack is exhausted.
+class StackScratchResource : public std::pmr::memory_resource {
+    StackAllocator* m_stack;
+    StackAllocator::Marker m_marker;
+    std::pmr::monotonic_buffer_resource m_overflow;
+public:
+    explicit StackScratchResource(StackAllocator* stack, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    StackScratchResource(const StackScratchResource&) = delete;
+    StackScratchResource& operator=(const StackScratchResource&) = delete;
+
+    virtual ~StackScratchResource();
+
+    void release();
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    virtual void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif /* MEMORYRESOURCE_H */
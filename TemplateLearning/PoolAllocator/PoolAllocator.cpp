@@ -2,60 +2,69 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>     /* malloc, free */
+#include <string.h>     /* memset */
 #include <algorithm>    //max
-#ifdef _DEBUG
-#include <iostream>
-#endif
 
-PoolAllocator::PoolAllocator(const std::size_t totalSize, const std::size_t chunkSize)
+template <template <class> class FreeList>
+BasicPoolAllocator<FreeList>::BasicPoolAllocator(const std::size_t totalSize, const std::size_t chunkSize, const unsigned arenaFlags)
 : Allocator(totalSize) {
-    assert(chunkSize >= 8 && "Chunk size must be greater or equal to 8");
+    assert(chunkSize >= MinChunkSize && "Chunk size must be able to hold a free-list node");
     assert(totalSize % chunkSize == 0 && "Total Size must be a multiple of Chunk Size");
     this->m_chunkSize = chunkSize;
+    this->m_arenaFlags = arenaFlags;
 }
 
-void PoolAllocator::Init() {
-    m_start_ptr = malloc(m_totalSize);
+template <template <class> class FreeList>
+void BasicPoolAllocator<FreeList>::Init() {
+    if (m_arenaFlags & VirtualMemory::Mapped) {
+        m_start_ptr = VirtualMemory::Map(m_totalSize, m_arenaFlags);
+        // Fresh anonymous pages read as zero
+        m_dirtySize = 0;
+    } else {
+        m_start_ptr = malloc(m_totalSize);
+        m_dirtySize = m_totalSize;
+    }
+    assert(m_start_ptr != nullptr && "Could not reserve the pool arena");
     this->Reset();
 }
 
-PoolAllocator::~PoolAllocator() {
-    free(m_start_ptr);
+template <template <class> class FreeList>
+BasicPoolAllocator<FreeList>::~BasicPoolAllocator() {
+    if (m_arenaFlags & VirtualMemory::Mapped) {
+        VirtualMemory::Unmap(m_start_ptr, m_totalSize);
+    } else {
+        free(m_start_ptr);
+    }
 }
 
-void *PoolAllocator::Allocate(const std::size_t allocationSize, const std::size_t alignment) {
-    assert(allocationSize == this->m_chunkSize && "Allocation size must be equal to chunk size");
-
-    Node * freePosition = m_freeList.pop();
-
-    assert(freePosition != nullptr && "The pool allocator is full");
-
-    m_used += m_chunkSize;
-    m_peak = std::max(m_peak, m_used);
-#ifdef _DEBUG
-    //std::cout << "A" << "\t@S " << m_start_ptr << "\t@R " << (void*) freePosition << "\tM " << m_used << std::endl;
-#endif
-
-    return static_cast<void*>(freePosition);
+template <template <class> class FreeList>
+void BasicPoolAllocator<FreeList>::Reset() {
+    Reset(false);
 }
 
-void PoolAllocator::Free(void * ptr) {
-    m_used -= m_chunkSize;
+template <template <class> class FreeList>
+void BasicPoolAllocator<FreeList>::Reset(const bool zeroChunks) {
+    // Everything below the bump offset has been handed out since the last Reset
+    m_dirtySize = std::max(m_dirtySize, m_bumpOffset);
+    if (zeroChunks) {
+        memset(m_start_ptr, 0, m_dirtySize);
+        m_dirtySize = 0;
+    }
 
-    m_freeList.push(static_cast<Node *>(ptr));
+    m_used = 0;
+    m_peak = 0;
+    // The free list only holds returned chunks; the rest are carved lazily
+    // from the bump region, so Reset only touches the arena pages when zeroing
+    m_freeList.clear();
+    m_bumpOffset = 0;
+}
 
-#ifdef _DEBUG
-    //std::cout << "F" << "\t@S " << m_start_ptr << "\t@F " << ptr << "\tM " << m_used << std::endl;
-#endif
+template <template <class> class FreeList>
+bool BasicPoolAllocator<FreeList>::Owns(const void* ptr) const {
+    const std::size_t address = reinterpret_cast<std::size_t>(ptr);
+    const std::size_t start = reinterpret_cast<std::size_t>(m_start_ptr);
+    return address >= start && address < start + m_totalSize;
 }
 
-void PoolAllocator::Reset() {
-    m_used = 0;
-    m_peak = 0;
-    // Create a linked-list with all free positions
-    const int nChunks = m_totalSize / m_chunkSize;
-    for (auto i = 0; i < nChunks; ++i) {
-	    const std::size_t address = reinterpret_cast<std::size_t>(m_start_ptr) + i * m_chunkSize;
-        m_freeList.push(reinterpret_cast<Node *>(address));
-    }
-}
\ No newline at end of file
+template class BasicPoolAllocator<StackLinkedList>;
+template class BasicPoolAllocator<ConcurrentStackLinkedList>;
@@ -1,29 +1,85 @@
+#ifndef POOLALLOCATOR_H
+#define POOLALLOCATOR_H
+
 #include "Allocator.h"
 #include "StackLinkedList.h"
+#include "ConcurrentStackLinkedList.h"
+#include "VirtualMemory.h"
+#include <new>      // placement new
+#include <utility>  // forward
 
-class PoolAllocator : public Allocator {
+// FreeList policy: StackLinkedList (single thread) or ConcurrentStackLinkedList
+// (chunks may be freed from a different thread than the one that allocated them).
+// The class is final and its hot path lives in PoolAllocatorImpl.h, so calls
+// through a PoolAllocator (rather than an Allocator) are statically dispatched.
+template <template <class> class FreeList = StackLinkedList>
+class BasicPoolAllocator final : public Allocator {
 private:
     struct  FreeHeader{
     };
 
-    using Node = StackLinkedList<FreeHeader>::Node;
-    StackLinkedList<FreeHeader> m_freeList;
+    using Node = typename FreeList<FreeHeader>::Node;
+    FreeList<FreeHeader> m_freeList;
 
     void * m_start_ptr = nullptr;
     std::size_t m_chunkSize;
+    // Chunks at or past this offset were never handed out and are not on the free list
+    std::size_t m_bumpOffset = 0;
+    // Arena bytes that may hold non-zero data (everything, for a malloc'd arena)
+    std::size_t m_dirtySize = 0;
+    unsigned m_arenaFlags;
 public:
-    PoolAllocator(const std::size_t totalSize, const std::size_t chunkSize);
+    // Smallest chunk that can hold the free-list link
+    static constexpr std::size_t MinChunkSize = sizeof(Node);
+
+    // arenaFlags: VirtualMemory::None for a malloc'd arena, or Mapped/HugePages/Populate
+    BasicPoolAllocator(const std::size_t totalSize, const std::size_t chunkSize, const unsigned arenaFlags = VirtualMemory::None);
 
-    virtual ~PoolAllocator();
+    virtual ~BasicPoolAllocator();
 
     virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
 
     virtual void Free(void* ptr) override;
 
+    // Fills out with up to count chunks, returns how many it got (fewer only when full)
+    std::size_t AllocateBatch(const std::size_t count, void** out);
+
+    void FreeBatch(void* const* ptrs, const std::size_t count);
+
+    // Constructs a T directly in a chunk. With no arguments T is default-initialised,
+    // so a trivial T keeps whatever the chunk holds (zeros after Reset(true)) and the
+    // caller writes its fields in place without building a copy first.
+    // nullptr when the pool is full; the chunk is given back if T's constructor throws.
+    template <class T, class... Args>
+    T* Emplace(Args&&... args);
+
+    template <class T>
+    void Destroy(T* object);
+
     virtual void Init() override;
 
     virtual void Reset();
+
+    // zeroChunks: also clear every chunk that may have been written, so each chunk
+    // reads as zero the first time it is handed out again. Costs one memset of the
+    // span used so far; recycled (freed and reallocated) chunks are not re-zeroed.
+    void Reset(const bool zeroChunks);
+
+    bool Owns(const void* ptr) const;
+
+    const void* Arena() const { return m_start_ptr; }
 private:
-    PoolAllocator(PoolAllocator &poolAllocator);
+    BasicPoolAllocator(BasicPoolAllocator &poolAllocator);
+
+    // Claims up to count never-used chunks starting at offset, returns how many
+    std::size_t TakeUntouched(const std::size_t count, std::size_t& offset);
+    void AddUsed(const std::size_t size);
+    void SubUsed(const std::size_t size);
+};
+
+using PoolAllocator = BasicPoolAllocator<StackLinkedList>;
+using ConcurrentPoolAllocator = BasicPoolAllocator<ConcurrentStackLinkedList>;
+
+#include "PoolAllocatorImpl.h"
 
-};
\ No newline at end of file
+#endif /* POOLALLOCATOR_H */
@@ -0,0 +1,160 @@
+#include "PoolAllocator.h"
+#include <assert.h>
+#include <algorithm>    //max, min
+#include <atomic>       //atomic_ref
+#include <cstdint>      //uintptr_t
+#include <type_traits>  //is_destructible
+#ifdef _DEBUG
+#include <iostream>
+#endif
+
+// Hot path of BasicPoolAllocator, kept in the header so loops over the
+// concrete (final) pool type inline it instead of dispatching through Allocator.
+
+template <template <class> class FreeList>
+inline void *BasicPoolAllocator<FreeList>::Allocate(const std::size_t allocationSize, const std::size_t alignment) {
+    assert(allocationSize == this->m_chunkSize && "Allocation size must be equal to chunk size");
+
+    Node * freePosition = m_freeList.pop();
+    if (freePosition == nullptr) {
+        std::size_t offset;
+        if (TakeUntouched(1, offset) == 1) {
+            freePosition = reinterpret_cast<Node *>(static_cast<char*>(m_start_ptr) + offset);
+        }
+    }
+
+    assert(freePosition != nullptr && "The pool allocator is full");
+    if (freePosition == nullptr) {
+        return nullptr;
+    }
+
+    AddUsed(m_chunkSize);
+#ifdef _DEBUG
+    //std::cout << "A" << "\t@S " << m_start_ptr << "\t@R " << (void*) freePosition << "\tM " << m_used << std::endl;
+#endif
+
+    return static_cast<void*>(freePosition);
+}
+
+template <template <class> class FreeList>
+inline void BasicPoolAllocator<FreeList>::Free(void * ptr) {
+    SubUsed(m_chunkSize);
+
+    m_freeList.push(static_cast<Node *>(ptr));
+
+#ifdef _DEBUG
+    //std::cout << "F" << "\t@S " << m_start_ptr << "\t@F " << ptr << "\tM " << m_used << std::endl;
+#endif
+}
+
+template <template <class> class FreeList>
+inline std::size_t BasicPoolAllocator<FreeList>::AllocateBatch(const std::size_t count, void ** out) {
+    // Previously freed chunks first, unlinked in segments; a concurrent list may
+    // hand back a short segment under contention, only 0 means it is empty
+    std::size_t taken = 0;
+    while (taken < count) {
+        const std::size_t segment = m_freeList.popChain(reinterpret_cast<Node **>(out) + taken, count - taken);
+        if (segment == 0) {
+            break;
+        }
+        taken += segment;
+    }
+
+    // Then a contiguous run from the never-used region
+    std::size_t offset;
+    const std::size_t untouched = TakeUntouched(count - taken, offset);
+    char * chunk = static_cast<char*>(m_start_ptr) + offset;
+    for (std::size_t i = 0; i < untouched; ++i, chunk += m_chunkSize) {
+        out[taken++] = chunk;
+    }
+
+    AddUsed(taken * m_chunkSize);
+    return taken;
+}
+
+template <template <class> class FreeList>
+inline void BasicPoolAllocator<FreeList>::FreeBatch(void * const * ptrs, const std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+    SubUsed(count * m_chunkSize);
+
+    // Chain the chunks among themselves, then splice the whole segment in
+    for (std::size_t i = 0; i + 1 < count; ++i) {
+        FreeList<FreeHeader>::link(static_cast<Node *>(ptrs[i]), static_cast<Node *>(ptrs[i + 1]));
+    }
+    m_freeList.pushChain(static_cast<Node *>(ptrs[0]), static_cast<Node *>(ptrs[count - 1]));
+}
+
+template <template <class> class FreeList>
+template <class T, class... Args>
+inline T* BasicPoolAllocator<FreeList>::Emplace(Args&&... args) {
+    static_assert(std::is_destructible<T>::value, "Emplaced type must be destructible");
+    assert(sizeof(T) <= m_chunkSize && "Type does not fit in a chunk");
+
+    void * chunk = Allocate(m_chunkSize);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    assert(reinterpret_cast<std::uintptr_t>(chunk) % alignof(T) == 0 && "Chunk is not aligned for the type");
+    try {
+        if constexpr (sizeof...(Args) == 0) {
+            return ::new (chunk) T;
+        } else {
+            return ::new (chunk) T(std::forward<Args>(args)...);
+        }
+    } catch (...) {
+        Free(chunk);
+        throw;
+    }
+}
+
+template <template <class> class FreeList>
+template <class T>
+inline void BasicPoolAllocator<FreeList>::Destroy(T * object) {
+    object->~T();
+    Free(object);
+}
+
+template <template <class> class FreeList>
+inline std::size_t BasicPoolAllocator<FreeList>::TakeUntouched(const std::size_t count, std::size_t& offset) {
+    std::size_t taken;
+    if constexpr (FreeList<FreeHeader>::concurrent) {
+        std::atomic_ref<std::size_t> bump(m_bumpOffset);
+        offset = bump.load(std::memory_order_relaxed);
+        do {
+            taken = std::min(count, (m_totalSize - offset) / m_chunkSize);
+            if (taken == 0) {
+                return 0;
+            }
+        } while (!bump.compare_exchange_weak(offset, offset + taken * m_chunkSize, std::memory_order_relaxed));
+    } else {
+        offset = m_bumpOffset;
+        taken = std::min(count, (m_totalSize - offset) / m_chunkSize);
+        m_bumpOffset += taken * m_chunkSize;
+    }
+    return taken;
+}
+
+template <template <class> class FreeList>
+inline void BasicPoolAllocator<FreeList>::AddUsed(const std::size_t size) {
+    if constexpr (FreeList<FreeHeader>::concurrent) {
+        const std::size_t used = std::atomic_ref<std::size_t>(m_used).fetch_add(size, std::memory_order_relaxed) + size;
+        std::atomic_ref<std::size_t> peak(m_peak);
+        std::size_t currentPeak = peak.load(std::memory_order_relaxed);
+        while (currentPeak < used && !peak.compare_exchange_weak(currentPeak, used, std::memory_order_relaxed)) {
+        }
+    } else {
+        m_used += size;
+        m_peak = std::max(m_peak, m_used);
+    }
+}
+
+template <template <class> class FreeList>
+inline void BasicPoolAllocator<FreeList>::SubUsed(const std::size_t size) {
+    if constexpr (FreeList<FreeHeader>::concurrent) {
+        std::atomic_ref<std::size_t>(m_used).fetch_sub(size, std::memory_order_relaxed);
+    } else {
+        m_used -= size;
+    }
+}
@@ -0,0 +1,217 @@
+#include "ShardedPoolAllocator.h"
+#include <assert.h>
+#include <algorithm>    //max, sort, upper_bound
+#include <cstddef>      //max_align_t
+
+namespace {
+    // Chunks handed back to the pool per FreeBatch while collecting
+    constexpr std::size_t CollectBatch = 64;
+}
+
+// Last registry lookup of this thread, so the hot path skips the hash map.
+// binding == nullptr records that the thread holds no shard of allocator id.
+struct ShardLookup {
+    std::uint64_t id = 0;
+    ShardedPoolAllocator::Binding* binding = nullptr;
+};
+
+thread_local ShardLookup t_lastLookup;
+
+ShardedPoolAllocator::ShardedPoolAllocator(const std::size_t shardSize, const std::size_t chunkSize, const std::size_t shardCount,
+                                           const std::size_t collectInterval)
+: Allocator(shardSize * shardCount) {
+    assert(shardCount > 0 && "Shard count must be greater than 0");
+    assert(collectInterval > 0 && "Collect interval must be greater than 0");
+    m_shardSize = shardSize;
+    m_chunkSize = chunkSize;
+    m_collectInterval = collectInterval;
+    m_peak = 0;
+    m_id = Registry::NextId();
+
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        m_shards.push_back(std::make_unique<Shard>(shardSize, chunkSize));
+    }
+}
+
+void ShardedPoolAllocator::Init() {
+    m_arenas.clear();
+    for (auto& shard : m_shards) {
+        shard->pool.Init();
+        shard->live = 0;
+        shard->reported = 0;
+        shard->sinceCollect = 0;
+        shard->remoteFree.store(nullptr, std::memory_order_relaxed);
+        m_arenas.emplace_back(reinterpret_cast<std::uintptr_t>(shard->pool.Arena()), shard.get());
+    }
+    std::sort(m_arenas.begin(), m_arenas.end());
+    m_used = 0;
+    m_peak = 0;
+}
+
+ShardedPoolAllocator::~ShardedPoolAllocator() {
+    Registry::Detach(m_bindings);
+}
+
+void *ShardedPoolAllocator::Allocate(const std::size_t allocationSize, const std::size_t alignment) {
+    assert(allocationSize == this->m_chunkSize && "Allocation size must be equal to chunk size");
+    // Chunks sit at multiples of the chunk size in malloc'd arenas
+    assert((alignment == 0 || (m_chunkSize % alignment == 0 && alignment <= alignof(std::max_align_t))) &&
+           "Alignment must divide the chunk size and not exceed the arena alignment");
+
+    Shard* shard = LocalShard(true);
+    if (shard == nullptr) {
+        assert(false && "More allocating threads than shards");
+        return nullptr;
+    }
+
+    void* chunk;
+    if (shard->pool.AllocateBatch(1, &chunk) == 0) {
+        CollectRemote(*shard);
+        if (shard->pool.AllocateBatch(1, &chunk) == 0) {
+            assert(false && "The pool allocator is full");
+            return nullptr;
+        }
+    }
+    ++shard->live;
+
+    // After the allocation, so a peak that lands on a pass is reported in full
+    if (++shard->sinceCollect >= m_collectInterval) {
+        CollectRemote(*shard);
+    }
+    return chunk;
+}
+
+void ShardedPoolAllocator::Free(void * ptr) {
+    Shard* local = LocalShard(false);
+    if (local != nullptr && local->pool.Owns(ptr)) {
+        local->pool.Free(ptr);
+        --local->live;
+        return;
+    }
+
+    Shard* shard = FindShard(ptr);
+    assert(shard != nullptr && "Pointer does not belong to this allocator");
+
+    RemoteNode* node = static_cast<RemoteNode*>(ptr);
+    RemoteNode* head = shard->remoteFree.load(std::memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!shard->remoteFree.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void ShardedPoolAllocator::Collect() {
+    Shard* shard = LocalShard(false);
+    if (shard != nullptr) {
+        CollectRemote(*shard);
+    }
+}
+
+ShardedPoolAllocator::Shard* ShardedPoolAllocator::LocalShard(const bool claim) {
+    if (t_lastLookup.id != m_id) {
+        t_lastLookup.id = m_id;
+        t_lastLookup.binding = Registry::Find(m_id);
+    }
+    if (t_lastLookup.binding != nullptr) {
+        return m_shards[t_lastLookup.binding->shard].get();
+    }
+    if (!claim) {
+        return nullptr;
+    }
+
+    std::size_t index = m_shards.size();
+    {
+        std::lock_guard<std::mutex> shardLock(m_shardMutex);
+        for (std::size_t i = 0; i < m_shards.size(); ++i) {
+            if (!m_shards[i]->claimed) {
+                m_shards[i]->claimed = true;
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index == m_shards.size()) {
+        return nullptr;
+    }
+
+    // Outside m_shardMutex: an exiting thread takes the registry lock first
+    auto binding = Registry::Insert(m_id, this);
+    binding->shard = index;
+    t_lastLookup.binding = binding.get();
+
+    std::lock_guard<std::mutex> shardLock(m_shardMutex);
+    m_bindings.push_back(binding);
+    return m_shards[index].get();
+}
+
+ShardedPoolAllocator::Shard* ShardedPoolAllocator::FindShard(const void* ptr) const {
+    const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+    auto it = std::upper_bound(m_arenas.begin(), m_arenas.end(), std::make_pair(address, static_cast<Shard*>(nullptr)),
+                               [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    if (it == m_arenas.begin()) {
+        return nullptr;
+    }
+    --it;
+    return address < it->first + m_shardSize ? it->second : nullptr;
+}
+
+void ShardedPoolAllocator::CollectRemote(Shard& shard) {
+    shard.sinceCollect = 0;
+    if (shard.remoteFree.load(std::memory_order_relaxed) == nullptr) {
+        // Local allocations and frees still have to reach m_used/m_peak
+        Report(shard);
+        return;
+    }
+
+    // Take the whole list at once; pushers never see a half-detached list
+    RemoteNode* node = shard.remoteFree.exchange(nullptr, std::memory_order_acquire);
+    void* batch[CollectBatch];
+    std::size_t count = 0;
+    while (node != nullptr) {
+        RemoteNode* next = node->next;
+        batch[count++] = node;
+        if (count == CollectBatch) {
+            shard.pool.FreeBatch(batch, count);
+            shard.live -= count;
+            count = 0;
+        }
+        node = next;
+    }
+    shard.pool.FreeBatch(batch, count);
+    shard.live -= count;
+
+    Report(shard);
+}
+
+void ShardedPoolAllocator::Report(Shard& shard) {
+    // m_used/m_peak follow each shard as of its last collection pass (every
+    // collectInterval allocations, when the pool runs dry and on release), so the
+    // hot path never writes a cache line shared between threads. The peak is
+    // therefore sampled: a spike between two passes can be missed.
+    const std::size_t bytes = shard.live * m_chunkSize;
+    std::atomic_ref<std::size_t> used(m_used);
+    const std::size_t total = bytes >= shard.reported
+        ? used.fetch_add(bytes - shard.reported, std::memory_order_relaxed) + (bytes - shard.reported)
+        : used.fetch_sub(shard.reported - bytes, std::memory_order_relaxed) - (shard.reported - bytes);
+    shard.reported = bytes;
+
+    std::atomic_ref<std::size_t> peak(m_peak);
+    std::size_t currentPeak = peak.load(std::memory_order_relaxed);
+    while (currentPeak < total && !peak.compare_exchange_weak(currentPeak, total, std::memory_order_relaxed)) {
+    }
+}
+
+void ShardedPoolAllocator::Release(const std::size_t index) {
+    Shard& shard = *m_shards[index];
+    CollectRemote(shard);
+    Report(shard);
+
+    std::lock_guard<std::mutex> shardLock(m_shardMutex);
+    shard.claimed = false;
+}
+
+void ShardedPoolAllocator::ThreadExit(const std::shared_ptr<Binding>& binding) {
+    Release(binding->shard);
+
+    std::lock_guard<std::mutex> shardLock(m_shardMutex);
+    Registry::Forget(m_bindings, binding);
+}
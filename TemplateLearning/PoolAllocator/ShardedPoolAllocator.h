@@ -0,0 +1,87 @@
+#ifndef SHARDEDPOOLALLOCATOR_H
+#define SHARDEDPOOLALLOCATOR_H
+
+#include "Allocator.h"
+#include "PoolAllocator.h"
+#include "ThreadRegistry.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Per-thread pool ownership. Every allocating thread claims a shard (its own
+// PoolAllocator arena) and is the only one that touches that shard's free list.
+// A chunk freed by any other thread is pushed onto the owning shard's lock-free
+// remote-free list; the owner takes the whole list in one exchange and returns
+// it to its pool in batches, either every collectInterval allocations or when
+// the pool runs dry. A shard whose thread exits is handed to the next thread.
+class ShardedPoolAllocator : public Allocator {
+public:
+    struct Binding {
+        ShardedPoolAllocator* owner = nullptr;
+        std::size_t shard = 0;
+    };
+private:
+    struct RemoteNode {
+        RemoteNode* next;
+    };
+
+    struct alignas(64) Shard {
+        // Owner-only state
+        PoolAllocator pool;
+        std::size_t live = 0;
+        std::size_t reported = 0;
+        std::size_t sinceCollect = 0;
+        bool claimed = false;
+        // Written by other threads, kept off the owner's cache line
+        alignas(64) std::atomic<RemoteNode*> remoteFree{nullptr};
+
+        Shard(const std::size_t shardSize, const std::size_t chunkSize) : pool(shardSize, chunkSize) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    // Arena start of every shard, sorted, to find the owner of a freed chunk
+    std::vector<std::pair<std::uintptr_t, Shard*>> m_arenas;
+    std::mutex m_shardMutex;
+    std::size_t m_shardSize;
+    std::size_t m_chunkSize;
+    std::size_t m_collectInterval;
+    std::uint64_t m_id;
+
+    // Bindings of every thread holding a shard, detached on destruction
+    std::vector<std::shared_ptr<Binding>> m_bindings;
+public:
+    // shardCount bounds the number of threads allocating at the same time
+    ShardedPoolAllocator(const std::size_t shardSize, const std::size_t chunkSize, const std::size_t shardCount,
+                         const std::size_t collectInterval = 64);
+
+    virtual ~ShardedPoolAllocator();
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    // Any thread may free any chunk
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    // Returns chunks other threads freed back to the calling thread's shard
+    void Collect();
+private:
+    ShardedPoolAllocator(ShardedPoolAllocator &shardedPoolAllocator);
+
+    Shard* LocalShard(const bool claim);
+    Shard* FindShard(const void* ptr) const;
+    void CollectRemote(Shard& shard);
+    void Report(Shard& shard);
+    void Release(const std::size_t shard);
+
+    using Registry = ThreadRegistry<ShardedPoolAllocator, Binding>;
+    // A thread holding a shard exits: the shard is handed to the next thread
+    void ThreadExit(const std::shared_ptr<Binding>& binding);
+
+    friend Registry;
+};
+
+#endif /* SHARDEDPOOLALLOCATOR_H */
@@ -0,0 +1,131 @@
+#include "SizeClassAllocator.h"
+#include <assert.h>
+#include <stdlib.h>     /* malloc, free */
+#include <algorithm>    //max, sort, upper_bound
+#include <bit>          //has_single_bit
+#include <cstdint>      //uintptr_t
+
+SizeClassAllocator::SizeClassAllocator(const std::size_t bytesPerClass, const std::size_t minClassSize, const std::size_t maxClassSize)
+: Allocator(0) {
+    assert(std::has_single_bit(minClassSize) && std::has_single_bit(maxClassSize) && "Size classes must be powers of two");
+    assert(minClassSize >= 16 && minClassSize <= maxClassSize && "Smallest class must be at least 16 and not above the largest");
+    assert(bytesPerClass >= maxClassSize && "Every class needs room for at least one chunk");
+    m_bytesPerClass = bytesPerClass;
+    m_minClassSize = minClassSize;
+    m_maxClassSize = maxClassSize;
+    m_peak = 0;
+
+    for (std::size_t chunkSize = minClassSize; chunkSize <= maxClassSize; chunkSize <<= 1) {
+        const std::size_t chunkCount = bytesPerClass / chunkSize;
+        m_classes.push_back(SizeClass{std::make_unique<PoolAllocator>(chunkCount * chunkSize, chunkSize, VirtualMemory::Mapped), chunkSize, chunkCount, 0});
+        m_totalSize += chunkCount * chunkSize;
+    }
+}
+
+void SizeClassAllocator::Init() {
+    m_ranges.clear();
+    for (std::size_t index = 0; index < m_classes.size(); ++index) {
+        SizeClass& sizeClass = m_classes[index];
+        sizeClass.pool->Init();
+        sizeClass.liveCount = 0;
+        const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(sizeClass.pool->Arena());
+        m_ranges.push_back(ClassRange{start, start + sizeClass.chunkCount * sizeClass.chunkSize, index});
+    }
+    std::sort(m_ranges.begin(), m_ranges.end(), [](const ClassRange& left, const ClassRange& right) {
+        return left.start < right.start;
+    });
+    m_used = 0;
+    m_peak = 0;
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+
+}
+
+void* SizeClassAllocator::Allocate(const std::size_t size, const std::size_t alignment) {
+    assert((alignment == 0 || std::has_single_bit(alignment)) && "Alignment must be a power of two");
+
+    // Chunks of a power-of-two class are aligned to the class size (up to the page size)
+    const std::size_t classSize = std::max(size, alignment);
+    if (classSize > m_maxClassSize || alignment > VirtualMemory::PageSize()) {
+        return AllocateFallback(size, alignment);
+    }
+
+    SizeClass& sizeClass = m_classes[ClassIndex(classSize)];
+    if (sizeClass.liveCount == sizeClass.chunkCount) {
+        return AllocateFallback(size, alignment);
+    }
+
+    ++sizeClass.liveCount;
+    m_used += sizeClass.chunkSize;
+    m_peak = std::max(m_peak, m_used);
+    return sizeClass.pool->Allocate(sizeClass.chunkSize);
+}
+
+void SizeClassAllocator::Free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    const std::size_t index = OwningClass(ptr);
+    if (index != m_classes.size()) {
+        SizeClass& sizeClass = m_classes[index];
+        --sizeClass.liveCount;
+        m_used -= sizeClass.chunkSize;
+        sizeClass.pool->Free(ptr);
+        return;
+    }
+
+    FallbackHeader* header = static_cast<FallbackHeader*>(ptr) - 1;
+    m_used -= header->size;
+    free(header->base);
+}
+
+void SizeClassAllocator::Reset() {
+    for (auto& sizeClass : m_classes) {
+        sizeClass.pool->Reset();
+        sizeClass.liveCount = 0;
+    }
+    m_used = 0;
+    m_peak = 0;
+}
+
+std::size_t SizeClassAllocator::ClassIndex(const std::size_t size) const {
+    std::size_t index = 0;
+    for (std::size_t chunkSize = m_minClassSize; chunkSize < size; chunkSize <<= 1) {
+        ++index;
+    }
+    return index;
+}
+
+std::size_t SizeClassAllocator::OwningClass(const void* ptr) const {
+    // The arena starting last at or before ptr is the only one that can hold it
+    const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+    auto range = std::upper_bound(m_ranges.begin(), m_ranges.end(), address, [](const std::uintptr_t value, const ClassRange& classRange) {
+        return value < classRange.start;
+    });
+    if (range == m_ranges.begin() || address >= (--range)->end) {
+        return m_classes.size();
+    }
+    return range->index;
+}
+
+void* SizeClassAllocator::AllocateFallback(const std::size_t size, const std::size_t alignment) {
+    // malloc and the header keep 16-byte alignment; anything above needs padding
+    const std::size_t padding = alignment > alignof(FallbackHeader) ? alignment - alignof(FallbackHeader) : 0;
+    void* base = malloc(sizeof(FallbackHeader) + padding + size);
+    if (base == nullptr) {
+        return nullptr;
+    }
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(base) + sizeof(FallbackHeader);
+    if (padding != 0) {
+        address = (address + alignment - 1) & ~(alignment - 1);
+    }
+    FallbackHeader* header = reinterpret_cast<FallbackHeader*>(address) - 1;
+    header->size = size;
+    header->base = base;
+    m_used += size;
+    m_peak = std::max(m_peak, m_used);
+    return header + 1;
+}
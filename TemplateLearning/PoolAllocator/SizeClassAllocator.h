@@ -0,0 +1,66 @@
+#ifndef SIZECLASSALLOCATOR_H
+#define SIZECLASSALLOCATOR_H
+
+#include "Allocator.h"
+#include "PoolAllocator.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Segregated-fit allocator for mixed small objects: one PoolAllocator per
+// power-of-two size class from minClassSize to maxClassSize. Requests above
+// maxClassSize, or for a class whose pool is exhausted, fall back to malloc.
+// Class arenas are page-aligned mappings, so a chunk is aligned to its class
+// size up to the page size; an alignment above that goes to the fallback,
+// which pads the block to it.
+class SizeClassAllocator : public Allocator {
+private:
+    struct SizeClass {
+        std::unique_ptr<PoolAllocator> pool;
+        std::size_t chunkSize;
+        std::size_t chunkCount;
+        std::size_t liveCount;
+    };
+
+    // Right in front of every fallback block: the requested size and the
+    // malloc'd pointer, which differs from the header when the block was padded
+    struct alignas(16) FallbackHeader {
+        std::size_t size;
+        void* base;
+    };
+
+    // One class arena, for mapping a freed pointer back to its class
+    struct ClassRange {
+        std::uintptr_t start;
+        std::uintptr_t end;
+        std::size_t index;
+    };
+
+    std::vector<SizeClass> m_classes;
+    // Class arenas sorted by start address, rebuilt by Init
+    std::vector<ClassRange> m_ranges;
+    std::size_t m_bytesPerClass;
+    std::size_t m_minClassSize;
+    std::size_t m_maxClassSize;
+public:
+    SizeClassAllocator(const std::size_t bytesPerClass, const std::size_t minClassSize = 16, const std::size_t maxClassSize = 4096);
+
+    virtual ~SizeClassAllocator();
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    virtual void Reset();
+private:
+    SizeClassAllocator(SizeClassAllocator &sizeClassAllocator);
+
+    std::size_t ClassIndex(const std::size_t size) const;
+    // Class owning ptr, or m_classes.size() when ptr came from the fallback
+    std::size_t OwningClass(const void* ptr) const;
+    void* AllocateFallback(const std::size_t size, const std::size_t alignment);
+};
+
+#endif /* SIZECLASSALLOCATOR_H */
@@ -0,0 +1,129 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include "PoolAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// 32-bit reference to a SlotMap entry: slot index in the low bits, generation
+// in the rest. Value 0 is never handed out.
+//
+// Generations wrap, so a stale handle is only caught until its slot has been
+// reused 2^(31 - IndexBits) times (2048 with the default 20 index bits); keep
+// handles no longer than that or pick fewer index bits.
+struct SlotHandle {
+    std::uint32_t value = 0;
+
+    bool IsNull() const { return value == 0; }
+    bool operator==(const SlotHandle other) const { return value == other.value; }
+    bool operator!=(const SlotHandle other) const { return value != other.value; }
+};
+
+// Typed object table on top of a PoolAllocator. Live objects stay densely packed
+// in the pool arena (erase moves the last object into the hole and returns the
+// last chunk), so iteration is a linear walk. Handles go through a slot array and carry a generation, so a
+// handle to an erased object is detected instead of aliasing its successor.
+// Insert, Erase and Get are O(1). At most 2^IndexBits objects are live at a
+// time; erased slots are always reused. Not thread safe.
+template <class T, unsigned IndexBits = 20>
+class SlotMap {
+    static_assert(IndexBits > 0 && IndexBits < 32, "Handles need both index and generation bits");
+private:
+    static constexpr std::uint32_t IndexMask = (std::uint32_t(1) << IndexBits) - 1;
+    static constexpr std::uint32_t GenerationMask = ~std::uint32_t(0) >> IndexBits;
+    static constexpr std::uint32_t NoSlot = ~std::uint32_t(0);
+
+    struct Slot {
+        // Dense position while live, next free slot while free
+        std::uint32_t index;
+        // Odd while live, wraps within GenerationMask
+        std::uint32_t generation;
+    };
+
+    // Objects are allocated from and returned to the pool. Only ever freeing the chunk
+    // after the last live one keeps the free list in address order above it, so the
+    // pool hands out exactly the next dense position
+    PoolAllocator m_pool;
+    std::size_t m_chunkSize;
+    std::size_t m_capacity;
+    // First chunk of the pool; dense object i lives at m_base + i * m_chunkSize
+    char* m_base = nullptr;
+    std::size_t m_size = 0;
+
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_denseToSlot;
+    std::uint32_t m_freeSlot = NoSlot;
+public:
+    // Walks the live objects in dense order; the pool chunk may be wider than T
+    template <class U>
+    class DenseIterator {
+        char* m_ptr;
+        std::size_t m_stride;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = U;
+        using difference_type = std::ptrdiff_t;
+        using pointer = U*;
+        using reference = U&;
+
+        DenseIterator(char* ptr, const std::size_t stride) : m_ptr(ptr), m_stride(stride) {}
+
+        U& operator*() const { return *reinterpret_cast<U*>(m_ptr); }
+        U* operator->() const { return reinterpret_cast<U*>(m_ptr); }
+        DenseIterator& operator++() { m_ptr += m_stride; return *this; }
+        DenseIterator operator++(int) { DenseIterator old = *this; m_ptr += m_stride; return old; }
+        bool operator==(const DenseIterator& other) const { return m_ptr == other.m_ptr; }
+        bool operator!=(const DenseIterator& other) const { return m_ptr != other.m_ptr; }
+    };
+
+    using iterator = DenseIterator<T>;
+    using const_iterator = DenseIterator<const T>;
+
+    SlotMap(const std::size_t capacity, const unsigned arenaFlags = VirtualMemory::None);
+
+    ~SlotMap();
+
+    // Null handle when the map is full
+    template <class... Args>
+    SlotHandle Insert(Args&&... args);
+
+    // False if the handle is stale or null
+    bool Erase(const SlotHandle handle);
+
+    // nullptr if the handle is stale or null
+    T* Get(const SlotHandle handle);
+    const T* Get(const SlotHandle handle) const;
+
+    bool Contains(const SlotHandle handle) const { return Get(handle) != nullptr; }
+
+    // Dense access, 0 <= denseIndex < Size(); order changes on Erase
+    T& At(const std::size_t denseIndex);
+    SlotHandle HandleAt(const std::size_t denseIndex) const;
+
+    // Destroys every object and invalidates every handle
+    void Clear();
+
+    std::size_t Size() const { return m_size; }
+    std::size_t Capacity() const { return m_capacity; }
+
+    iterator begin() { return iterator(m_base, m_chunkSize); }
+    iterator end() { return iterator(m_base + m_size * m_chunkSize, m_chunkSize); }
+    const_iterator begin() const { return const_iterator(m_base, m_chunkSize); }
+    const_iterator end() const { return const_iterator(m_base + m_size * m_chunkSize, m_chunkSize); }
+private:
+    SlotMap(SlotMap &slotMap);
+
+    std::uint32_t FindDense(const SlotHandle handle) const;
+    T* DenseAddress(const std::size_t denseIndex) const;
+    void ReleaseSlot(const std::uint32_t slot);
+
+    static constexpr std::size_t ChunkSizeFor() {
+        return sizeof(T) > PoolAllocator::MinChunkSize ? sizeof(T) : PoolAllocator::MinChunkSize;
+    }
+};
+
+#include "SlotMapImpl.h"
+
+#endif /* SLOTMAP_H */
@@ -0,0 +1,137 @@
+#include "SlotMap.h"
+#include <assert.h>
+#include <new>          // placement new
+#include <utility>      //forward, move
+
+template <class T, unsigned IndexBits>
+SlotMap<T, IndexBits>::SlotMap(const std::size_t capacity, const unsigned arenaFlags)
+: m_pool(capacity * ChunkSizeFor(), ChunkSizeFor(), arenaFlags) {
+    assert(capacity > 0 && capacity <= std::size_t(IndexMask) + 1 && "Capacity must fit in the handle index bits");
+    m_chunkSize = ChunkSizeFor();
+    m_capacity = capacity;
+    m_pool.Init();
+    m_base = static_cast<char*>(const_cast<void*>(m_pool.Arena()));
+    m_slots.reserve(capacity);
+    m_denseToSlot.resize(capacity);
+}
+
+template <class T, unsigned IndexBits>
+SlotMap<T, IndexBits>::~SlotMap() {
+    Clear();
+}
+
+template <class T, unsigned IndexBits>
+template <class... Args>
+SlotHandle SlotMap<T, IndexBits>::Insert(Args&&... args) {
+    if (m_size == m_capacity) {
+        return SlotHandle{};
+    }
+
+    void* chunk = m_pool.Allocate(m_chunkSize);
+    assert(chunk == DenseAddress(m_size) && "Pool chunk is not the next dense position");
+    // Constructed before a slot is claimed, so a throwing constructor leaves the map as it was
+    try {
+        new (chunk) T(std::forward<Args>(args)...);
+    } catch (...) {
+        m_pool.Free(chunk);
+        throw;
+    }
+
+    std::uint32_t slot = m_freeSlot;
+    if (slot != NoSlot) {
+        m_freeSlot = m_slots[slot].index;
+    } else {
+        // Capacity <= 2^IndexBits, so a map that is not full always has an index left
+        slot = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.push_back(Slot{0, 0});
+    }
+
+    Slot& entry = m_slots[slot];
+    entry.index = static_cast<std::uint32_t>(m_size);
+    entry.generation = (entry.generation + 1) & GenerationMask;
+    m_denseToSlot[m_size] = slot;
+    ++m_size;
+
+    return SlotHandle{(entry.generation << IndexBits) | slot};
+}
+
+template <class T, unsigned IndexBits>
+bool SlotMap<T, IndexBits>::Erase(const SlotHandle handle) {
+    const std::uint32_t dense = FindDense(handle);
+    if (dense == NoSlot) {
+        return false;
+    }
+
+    const std::uint32_t slot = handle.value & IndexMask;
+    const std::size_t last = m_size - 1;
+    if (dense != last) {
+        // Fill the hole with the last object to keep the range dense
+        *DenseAddress(dense) = std::move(*DenseAddress(last));
+        const std::uint32_t movedSlot = m_denseToSlot[last];
+        m_denseToSlot[dense] = movedSlot;
+        m_slots[movedSlot].index = dense;
+    }
+    m_pool.Destroy(DenseAddress(last));
+    --m_size;
+
+    ReleaseSlot(slot);
+    return true;
+}
+
+template <class T, unsigned IndexBits>
+T* SlotMap<T, IndexBits>::Get(const SlotHandle handle) {
+    const std::uint32_t dense = FindDense(handle);
+    return dense == NoSlot ? nullptr : DenseAddress(dense);
+}
+
+template <class T, unsigned IndexBits>
+const T* SlotMap<T, IndexBits>::Get(const SlotHandle handle) const {
+    const std::uint32_t dense = FindDense(handle);
+    return dense == NoSlot ? nullptr : DenseAddress(dense);
+}
+
+template <class T, unsigned IndexBits>
+T& SlotMap<T, IndexBits>::At(const std::size_t denseIndex) {
+    assert(denseIndex < m_size && "Dense index out of range");
+    return *DenseAddress(denseIndex);
+}
+
+template <class T, unsigned IndexBits>
+SlotHandle SlotMap<T, IndexBits>::HandleAt(const std::size_t denseIndex) const {
+    assert(denseIndex < m_size && "Dense index out of range");
+    const std::uint32_t slot = m_denseToSlot[denseIndex];
+    return SlotHandle{(m_slots[slot].generation << IndexBits) | slot};
+}
+
+template <class T, unsigned IndexBits>
+void SlotMap<T, IndexBits>::Clear() {
+    while (m_size > 0) {
+        --m_size;
+        m_pool.Destroy(DenseAddress(m_size));
+        ReleaseSlot(m_denseToSlot[m_size]);
+    }
+}
+
+template <class T, unsigned IndexBits>
+std::uint32_t SlotMap<T, IndexBits>::FindDense(const SlotHandle handle) const {
+    const std::uint32_t slot = handle.value & IndexMask;
+    const std::uint32_t generation = handle.value >> IndexBits;
+    // Live generations are odd, which also rules out the null handle
+    if ((generation & 1) == 0 || slot >= m_slots.size() || m_slots[slot].generation != generation) {
+        return NoSlot;
+    }
+    return m_slots[slot].index;
+}
+
+template <class T, unsigned IndexBits>
+T* SlotMap<T, IndexBits>::DenseAddress(const std::size_t denseIndex) const {
+    return reinterpret_cast<T*>(m_base + denseIndex * m_chunkSize);
+}
+
+template <class T, unsigned IndexBits>
+void SlotMap<T, IndexBits>::ReleaseSlot(const std::uint32_t slot) {
+    Slot& entry = m_slots[slot];
+    entry.generation = (entry.generation + 1) & GenerationMask;
+    entry.index = m_freeSlot;
+    m_freeSlot = slot;
+}
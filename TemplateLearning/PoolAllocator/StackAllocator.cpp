@@ -1,5 +1,6 @@
 #include "StackAllocator.h"
 #include "Utils.h"  /* CalculatePadding */
+#include <assert.h>
 #include <stdlib.h>     /* malloc, free */
 #include <algorithm>    /* max */
 #ifdef _DEBUG
@@ -8,7 +9,8 @@
 
 StackAllocator::StackAllocator(const std::size_t totalSize)
 : Allocator(totalSize) {
-
+    m_offset = 0;
+    m_topOffset = 0;
 }
 
 void StackAllocator::Init() {
@@ -17,6 +19,7 @@ void StackAllocator::Init() {
     }
     m_start_ptr = malloc(m_totalSize);
     m_offset = 0;
+    m_topOffset = 0;
 }
 
 StackAllocator::~StackAllocator() {
@@ -27,26 +30,24 @@ StackAllocator::~StackAllocator() {
 void* StackAllocator::Allocate(const std::size_t size, const std::size_t alignment) {
     const std::size_t currentAddress = (std::size_t)m_start_ptr + m_offset;
 
-    std::size_t padding = Utils::CalculatePaddingWithHeader(currentAddress, alignment, sizeof (AllocationHeader));
+    std::size_t padding = Utils::CalculatePaddingWithHeader(currentAddress, EffectiveAlignment(alignment), sizeof (AllocationHeader));
 
-    if (m_offset + padding + size > m_totalSize) {
+    if (m_offset + padding + size > m_totalSize - m_topOffset) {
         return nullptr;
     }
     m_offset += padding;
 
     const std::size_t nextAddress = currentAddress + padding;
     const std::size_t headerAddress = nextAddress - sizeof (AllocationHeader);
-    AllocationHeader allocationHeader{padding};
     AllocationHeader * headerPtr = (AllocationHeader*) headerAddress;
-    headerPtr = &allocationHeader;
-    
+    headerPtr->padding = padding;
+
     m_offset += size;
 
 #ifdef _DEBUG
     std::cout << "A" << "\t@C " << (void*) currentAddress << "\t@R " << (void*) nextAddress << "\tO " << m_offset << "\tP " << padding << std::endl;
 #endif
-    m_used = m_offset;
-    m_peak = std::max(m_peak, m_used);
+    UpdateUsage();
 
     return (void*) nextAddress;
 }
@@ -58,15 +59,78 @@ void StackAllocator::Free(void *ptr) {
     const AllocationHeader * allocationHeader{ (AllocationHeader *) headerAddress};
 
     m_offset = currentAddress - allocationHeader->padding - (std::size_t) m_start_ptr;
-    m_used = m_offset;
+    UpdateUsage();
 
 #ifdef _DEBUG
     std::cout << "F" << "\t@C " << (void*) currentAddress << "\t@F " << (void*) ((char*) m_start_ptr + m_offset) << "\tO " << m_offset << std::endl;
 #endif
 }
 
+void* StackAllocator::AllocateTop(const std::size_t size, const std::size_t alignment) {
+    const std::size_t endAddress = (std::size_t)m_start_ptr + m_totalSize;
+    const std::size_t currentAddress = endAddress - m_topOffset;
+    const std::size_t effectiveAlignment = EffectiveAlignment(alignment);
+
+    // Block goes below the current top, aligned down, header right beneath it
+    if (size + sizeof (AllocationHeader) > currentAddress - ((std::size_t)m_start_ptr + m_offset)) {
+        return nullptr;
+    }
+    const std::size_t nextAddress = (currentAddress - size) & ~(effectiveAlignment - 1);
+    const std::size_t headerAddress = nextAddress - sizeof (AllocationHeader);
+    if (headerAddress < (std::size_t)m_start_ptr + m_offset) {
+        return nullptr;
+    }
+
+    AllocationHeader * headerPtr = (AllocationHeader*) headerAddress;
+    headerPtr->padding = currentAddress - nextAddress;
+    m_topOffset = endAddress - headerAddress;
+
+#ifdef _DEBUG
+    std::cout << "AT" << "\t@C " << (void*) currentAddress << "\t@R " << (void*) nextAddress << "\tO " << m_topOffset << std::endl;
+#endif
+    UpdateUsage();
+
+    return (void*) nextAddress;
+}
+
+void StackAllocator::FreeTop(void *ptr) {
+    const std::size_t currentAddress = (std::size_t) ptr;
+    const AllocationHeader * allocationHeader{ (AllocationHeader *) (currentAddress - sizeof (AllocationHeader))};
+
+    m_topOffset = (std::size_t)m_start_ptr + m_totalSize - currentAddress - allocationHeader->padding;
+    UpdateUsage();
+
+#ifdef _DEBUG
+    std::cout << "FT" << "\t@C " << (void*) currentAddress << "\tO " << m_topOffset << std::endl;
+#endif
+}
+
+void StackAllocator::FreeToMarker(const Marker marker) {
+    assert(marker <= m_offset && "Marker is above the current bottom offset");
+    m_offset = marker;
+    UpdateUsage();
+}
+
+void StackAllocator::FreeToTopMarker(const Marker marker) {
+    assert(marker <= m_topOffset && "Marker is above the current top offset");
+    m_topOffset = marker;
+    UpdateUsage();
+}
+
 void StackAllocator::Reset() {
     m_offset = 0;
+    m_topOffset = 0;
     m_used = 0;
     m_peak = 0;
-}
\ No newline at end of file
+}
+
+std::size_t StackAllocator::EffectiveAlignment(const std::size_t alignment) {
+    // Header must stay aligned, and CalculatePadding cannot take 0
+    assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+    return std::max(alignment, alignof(AllocationHeader));
+}
+
+void StackAllocator::UpdateUsage() {
+    m_used = m_offset + m_topOffset;
+    m_peak = std::max(m_peak, m_used);
+}
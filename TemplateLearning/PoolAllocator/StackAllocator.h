@@ -3,10 +3,19 @@
 
 #include "Allocator.h"
 
+// Frame allocator over one block. Bottom allocations grow up from the start,
+// top allocations grow down from the end (double-ended mode), so per-request
+// scratch and longer-lived data can share the block without interleaving.
+// Each side is LIFO: Free releases the most recent allocation of that side,
+// FreeToMarker rolls a side back to a marker in O(1).
 class StackAllocator : public Allocator {
+public:
+    using Marker = std::size_t;
 protected:
     void* m_start_ptr = nullptr;
     std::size_t m_offset;
+    // Bytes taken from the end of the block by top allocations
+    std::size_t m_topOffset;
 public:
     StackAllocator(const std::size_t totalSize);
 
@@ -19,13 +28,29 @@ public:
     virtual void Init() override;
 
     virtual void Reset();
+
+    void* AllocateTop(const std::size_t size, const std::size_t alignment = 0);
+
+    void FreeTop(void* ptr);
+
+    Marker GetMarker() const { return m_offset; }
+
+    void FreeToMarker(const Marker marker);
+
+    Marker GetTopMarker() const { return m_topOffset; }
+
+    void FreeToTopMarker(const Marker marker);
 private:
     StackAllocator(StackAllocator &stackAllocator);
 
+    // Stored right before every returned block: distance from the block back
+    // to the side's boundary before the allocation was made
     struct AllocationHeader {
-        char padding;
+        std::size_t padding;
     };
 
+    static std::size_t EffectiveAlignment(const std::size_t alignment);
+    void UpdateUsage();
 };
 
-#endif /* STACKALLOCATOR_H */
\ No newline at end of file
+#endif /* STACKALLOCATOR_H */
@@ -1,6 +1,8 @@
 #ifndef STACKLINKEDLIST_H
 #define STACKLINKEDLIST_H
 
+#include <cstddef> // size_t
+
 template <class T>
 class StackLinkedList {
 public:
@@ -10,11 +12,23 @@ public:
     };
     
     Node* head;
+
+    // Single-threaded list: callers must serialize push/pop
+    static constexpr bool concurrent = false;
 public:
     StackLinkedList();
 
     void push(Node * newNode);
     Node* pop();
+    void clear();
+
+    // Link a pre-chained first..last segment in one step
+    void pushChain(Node * first, Node * last);
+    // Unlink up to count nodes into out, returns how many were taken
+    std::size_t popChain(Node ** out, const std::size_t count);
+
+    // Sets node->next, for callers that pre-chain a segment for pushChain
+    static void link(Node * node, Node * next);
 private:
     StackLinkedList(StackLinkedList &stackLinkedList);
 };
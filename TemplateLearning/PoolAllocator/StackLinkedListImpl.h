@@ -1,7 +1,8 @@
 #include "StackLinkedList.h"
 
 template <class T>
-StackLinkedList<T>::StackLinkedList() {
+StackLinkedList<T>::StackLinkedList()
+: head(nullptr) {
 
 }
 
@@ -14,6 +15,36 @@ void StackLinkedList<T>::push(Node * newNode) {
 template <class T>
 typename StackLinkedList<T>::Node* StackLinkedList<T>::pop() {
     Node * top = head;
-    head = head->next;
+    if (top != nullptr) {
+        head = top->next;
+    }
     return top;
-}
\ No newline at end of file
+}
+
+template <class T>
+void StackLinkedList<T>::clear() {
+    head = nullptr;
+}
+
+template <class T>
+void StackLinkedList<T>::pushChain(Node * first, Node * last) {
+    last->next = head;
+    head = first;
+}
+
+template <class T>
+std::size_t StackLinkedList<T>::popChain(Node ** out, const std::size_t count) {
+    std::size_t taken = 0;
+    Node * node = head;
+    while (taken < count && node != nullptr) {
+        out[taken++] = node;
+        node = node->next;
+    }
+    head = node;
+    return taken;
+}
+
+template <class T>
+void StackLinkedList<T>::link(Node * node, Node * next) {
+    node->next = next;
+}
@@ -0,0 +1,102 @@
+#include "ThreadCachePoolAllocator.h"
+#include <assert.h>
+#include <algorithm>    //max
+
+ThreadCachePoolAllocator::ThreadCachePoolAllocator(const std::size_t totalSize, const std::size_t chunkSize, const std::size_t batchSize)
+: Allocator(totalSize)
+, m_pool(totalSize, chunkSize) {
+    assert(batchSize > 0 && "Batch size must be greater than 0");
+    m_chunkSize = chunkSize;
+    m_batchSize = batchSize;
+    m_peak = 0;
+    m_id = Registry::NextId();
+}
+
+void ThreadCachePoolAllocator::Init() {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    // Chunks still cached from before would be handed out by the new free list too
+    for (auto& magazine : m_magazines) {
+        magazine->chunks.clear();
+    }
+    m_pool.Init();
+    m_used = 0;
+    m_peak = 0;
+}
+
+ThreadCachePoolAllocator::~ThreadCachePoolAllocator() {
+    Registry::Detach(m_magazines);
+}
+
+void *ThreadCachePoolAllocator::Allocate(const std::size_t allocationSize, const std::size_t alignment) {
+    assert(allocationSize == this->m_chunkSize && "Allocation size must be equal to chunk size");
+
+    Magazine& magazine = LocalMagazine();
+    if (magazine.chunks.empty() && Refill(magazine) == 0) {
+        assert(false && "The pool allocator is full");
+        return nullptr;
+    }
+
+    void* chunk = magazine.chunks.back();
+    magazine.chunks.pop_back();
+    return chunk;
+}
+
+void ThreadCachePoolAllocator::Free(void * ptr) {
+    Magazine& magazine = LocalMagazine();
+    magazine.chunks.push_back(ptr);
+
+    // Keep one batch cached so an alloc/free ping-pong never hits the pool
+    if (magazine.chunks.size() >= 2 * m_batchSize) {
+        Drain(magazine, m_batchSize);
+    }
+}
+
+void ThreadCachePoolAllocator::FlushThreadCache() {
+    Magazine& magazine = LocalMagazine();
+    Drain(magazine, magazine.chunks.size());
+}
+
+ThreadCachePoolAllocator::Magazine& ThreadCachePoolAllocator::LocalMagazine() {
+    if (Magazine* magazine = Registry::Find(m_id)) {
+        return *magazine;
+    }
+
+    auto magazine = Registry::Insert(m_id, this);
+    magazine->chunks.reserve(2 * m_batchSize);
+
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    m_magazines.push_back(magazine);
+    return *magazine;
+}
+
+void ThreadCachePoolAllocator::ThreadExit(const std::shared_ptr<Magazine>& magazine) {
+    Drain(*magazine, magazine->chunks.size());
+
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+    Registry::Forget(m_magazines, magazine);
+}
+
+std::size_t ThreadCachePoolAllocator::Refill(Magazine& magazine) {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+
+    // One free-list segment per refill instead of a pop per chunk
+    const std::size_t first = magazine.chunks.size();
+    magazine.chunks.resize(first + m_batchSize);
+    const std::size_t count = m_pool.AllocateBatch(m_batchSize, magazine.chunks.data() + first);
+    magazine.chunks.resize(first + count);
+
+    m_used += count * m_chunkSize;
+    m_peak = std::max(m_peak, m_used);
+    return count;
+}
+
+void ThreadCachePoolAllocator::Drain(Magazine& magazine, const std::size_t count) {
+    std::lock_guard<std::mutex> poolLock(m_poolMutex);
+
+    // The newest count chunks go back as one segment
+    const std::size_t remaining = magazine.chunks.size() - count;
+    m_pool.FreeBatch(magazine.chunks.data() + remaining, count);
+    magazine.chunks.resize(remaining);
+
+    m_used -= count * m_chunkSize;
+}
@@ -0,0 +1,58 @@
+#ifndef THREADCACHEPOOLALLOCATOR_H
+#define THREADCACHEPOOLALLOCATOR_H
+
+#include "Allocator.h"
+#include "PoolAllocator.h"
+#include "ThreadRegistry.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Thread-caching front end for PoolAllocator.
+// Every thread keeps a small magazine of chunks; Allocate/Free only touch the
+// magazine and fall through to the shared pool (under m_poolMutex) once per
+// batch, when the magazine runs empty or overflows.
+class ThreadCachePoolAllocator : public Allocator {
+public:
+    struct Magazine {
+        ThreadCachePoolAllocator* owner = nullptr;
+        std::vector<void*> chunks;
+    };
+private:
+    PoolAllocator m_pool;
+    std::mutex m_poolMutex;
+    std::size_t m_chunkSize;
+    std::size_t m_batchSize;
+    std::uint64_t m_id;
+
+    // Magazines of every thread that touched this allocator, detached on destruction
+    std::vector<std::shared_ptr<Magazine>> m_magazines;
+public:
+    ThreadCachePoolAllocator(const std::size_t totalSize, const std::size_t chunkSize, const std::size_t batchSize = 32);
+
+    virtual ~ThreadCachePoolAllocator();
+
+    virtual void* Allocate(const std::size_t size, const std::size_t alignment = 0) override;
+
+    virtual void Free(void* ptr) override;
+
+    virtual void Init() override;
+
+    // Returns the calling thread's cached chunks to the shared pool
+    void FlushThreadCache();
+private:
+    ThreadCachePoolAllocator(ThreadCachePoolAllocator &threadCachePoolAllocator);
+
+    Magazine& LocalMagazine();
+    std::size_t Refill(Magazine& magazine);
+    void Drain(Magazine& magazine, const std::size_t count);
+
+    using Registry = ThreadRegistry<ThreadCachePoolAllocator, Magazine>;
+    // A thread with a magazine exits: its chunks go back to the pool
+    void ThreadExit(const std::shared_ptr<Magazine>& magazine);
+
+    friend Registry;
+};
+
+#endif /* THREADCACHEPOOLALLOCATOR_H */
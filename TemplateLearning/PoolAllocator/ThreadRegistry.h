@@ -0,0 +1,79 @@
+#ifndef THREADREGISTRY_H
+#define THREADREGISTRY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Per-thread state that an allocator keeps for every thread using it
+// (ThreadCachePoolAllocator magazines, ShardedPoolAllocator shard bindings).
+// Each thread has one Entry per Owner it touched, keyed by the owner's id so
+// the entry of a destroyed owner is never matched again. Entry needs an
+// `Owner* owner` member. The owner keeps its entries in a list, Detaches them
+// when it dies, and implements ThreadExit(std::shared_ptr<Entry> const&),
+// which runs under the owner mutex when a thread still holding an entry exits.
+template <class Owner, class Entry>
+class ThreadRegistry {
+public:
+    static std::uint64_t NextId() {
+        return s_nextId++;
+    }
+
+    // The calling thread's entry for owner id, nullptr if it has none
+    static Entry* Find(const std::uint64_t id) {
+        auto found = t_table.entries.find(id);
+        return found != t_table.entries.end() ? found->second.get() : nullptr;
+    }
+
+    // Adds the calling thread's entry for owner. Also drops the entries of owners
+    // that died meanwhile, so a long-lived thread does not collect one per owner.
+    static std::shared_ptr<Entry> Insert(const std::uint64_t id, Owner* owner) {
+        auto& entries = t_table.entries;
+        {
+            std::lock_guard<std::mutex> ownerLock(s_ownerMutex);
+            std::erase_if(entries, [](const auto& entry) { return entry.second->owner == nullptr; });
+        }
+
+        auto entry = std::make_shared<Entry>();
+        entry->owner = owner;
+        entries.emplace(id, entry);
+        return entry;
+    }
+
+    // Called by a dying owner; threads skip and later purge the detached entries
+    static void Detach(const std::vector<std::shared_ptr<Entry>>& entries) {
+        std::lock_guard<std::mutex> ownerLock(s_ownerMutex);
+        for (auto& entry : entries) {
+            entry->owner = nullptr;
+        }
+    }
+
+    // For ThreadExit: removes entry from the owner's list
+    static void Forget(std::vector<std::shared_ptr<Entry>>& entries, const std::shared_ptr<Entry>& entry) {
+        entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+    }
+private:
+    struct Table {
+        std::unordered_map<std::uint64_t, std::shared_ptr<Entry>> entries;
+
+        ~Table() {
+            std::lock_guard<std::mutex> ownerLock(s_ownerMutex);
+            for (auto& entry : entries) {
+                if (entry.second->owner != nullptr) {
+                    entry.second->owner->ThreadExit(entry.second);
+                }
+            }
+        }
+    };
+
+    static inline std::atomic<std::uint64_t> s_nextId{1};
+    // Guards Entry::owner between exiting threads and a dying owner
+    static inline std::mutex s_ownerMutex;
+    static inline thread_local Table t_table;
+};
+
+#endif /* THREADREGISTRY_H */
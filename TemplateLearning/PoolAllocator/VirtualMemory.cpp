@@ -0,0 +1,128 @@
+#include "VirtualMemory.h"
+#include <assert.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+}
+
+std::size_t VirtualMemory::PageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+#ifdef _WIN32
+
+void* VirtualMemory::Map(const std::size_t size, const unsigned flags) {
+    void* ptr = nullptr;
+    const std::size_t largePage = GetLargePageMinimum();
+    if ((flags & HugePages) == HugePages && largePage != 0 && size % largePage == 0) {
+        // Large pages are always resident; fails without SeLockMemoryPrivilege
+        ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+    if (ptr == nullptr) {
+        ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (ptr != nullptr && (flags & Populate) == Populate) {
+            const std::size_t pageSize = PageSize();
+            for (std::size_t offset = 0; offset < size; offset += pageSize) {
+                static_cast<volatile char*>(ptr)[offset] = 0;
+            }
+        }
+    }
+    return ptr;
+}
+
+void VirtualMemory::Unmap(void* ptr, const std::size_t size) {
+    if (ptr != nullptr) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+}
+
+void* VirtualMemory::Remap(void* ptr, const std::size_t oldSize, const std::size_t newSize) {
+    // VirtualAlloc regions cannot be moved; the caller copies
+    return nullptr;
+}
+
+#else
+
+void* VirtualMemory::Map(const std::size_t size, const unsigned flags) {
+    int mmapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if ((flags & Populate) == Populate) {
+        mmapFlags |= MAP_POPULATE;
+    }
+
+    if ((flags & HugePages) != HugePages) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, mmapFlags, -1, 0);
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+        if ((flags & Sequential) == Sequential) {
+            madvise(ptr, size, MADV_SEQUENTIAL);
+        }
+        return ptr;
+    }
+
+    // Over-map and trim so the arena starts on a huge page boundary
+    const std::size_t mappedSize = size + HUGE_PAGE_SIZE;
+    void* raw = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, mmapFlags & ~MAP_POPULATE, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    const uintptr_t rawAddress = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t alignedAddress = (rawAddress + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    const std::size_t head = alignedAddress - rawAddress;
+    const std::size_t pageSize = PageSize();
+    const std::size_t usedSize = (size + pageSize - 1) / pageSize * pageSize;
+    if (head != 0) {
+        munmap(raw, head);
+    }
+    munmap(reinterpret_cast<void*>(alignedAddress + usedSize), mappedSize - head - usedSize);
+
+    void* ptr = reinterpret_cast<void*>(alignedAddress);
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, usedSize, MADV_HUGEPAGE);
+#endif
+    if ((flags & Sequential) == Sequential) {
+        madvise(ptr, usedSize, MADV_SEQUENTIAL);
+    }
+    if ((flags & Populate) == Populate) {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(ptr, usedSize, MADV_POPULATE_WRITE) != 0)
+#endif
+        {
+            for (std::size_t offset = 0; offset < usedSize; offset += pageSize) {
+                static_cast<volatile char*>(ptr)[offset] = 0;
+            }
+        }
+    }
+    return ptr;
+}
+
+void VirtualMemory::Unmap(void* ptr, const std::size_t size) {
+    if (ptr != nullptr) {
+        munmap(ptr, size);
+    }
+}
+
+void* VirtualMemory::Remap(void* ptr, const std::size_t oldSize, const std::size_t newSize) {
+#ifdef MREMAP_MAYMOVE
+    // The madvise hints live on the mapping and move with it
+    void* moved = mremap(ptr, oldSize, newSize, MREMAP_MAYMOVE);
+    return moved == MAP_FAILED ? nullptr : moved;
+#else
+    return nullptr;
+#endif
+}
+
+#endif
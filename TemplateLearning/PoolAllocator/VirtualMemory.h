@@ -0,0 +1,33 @@
+#ifndef VIRTUALMEMORY_H
+#define VIRTUALMEMORY_H
+
+#include <cstddef> // size_t
+
+// Anonymous page mappings straight from the OS (mmap / VirtualAlloc),
+// for arenas that should bypass malloc.
+class VirtualMemory {
+public:
+    enum Flags : unsigned {
+        None      = 0,
+        Mapped    = 1 << 0,
+        // Transparent huge pages on Linux, large pages on Windows when the process may use them
+        HugePages = Mapped | 1 << 1,
+        // Fault every page in up front instead of on first touch
+        Populate  = Mapped | 1 << 2,
+        // Read-ahead hint for buffers scanned front to back (Linux only)
+        Sequential = Mapped | 1 << 3
+    };
+
+    static void* Map(const std::size_t size, const unsigned flags);
+
+    // Resizes a mapping made by Map, moving it if it cannot grow in place.
+    // The pages move with it, so no byte is copied. Returns nullptr where the
+    // OS has no such call (Windows) or on failure; the old mapping is then intact.
+    static void* Remap(void* ptr, const std::size_t oldSize, const std::size_t newSize);
+
+    static void Unmap(void* ptr, const std::size_t size);
+
+    static std::size_t PageSize();
+};
+
+#endif /* VIRTUALMEMORY_H */
@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LinearAllocator.h"
+
+// Per-thread scratch memory for short-lived std containers: TempStdAllocator
+// carves from the calling thread's LinearAllocator and only gives back the top
+// allocation, a TempAllocatorScope rewinds everything allocated inside it on
+// exit, including any blocks the arena grew by. Scopes nest and must end in
+// LIFO order.
+//
+// tlsLinearAllocator may be set by hand; otherwise the thread's first use
+// leases an arena from ScratchArenaRegistry, which takes it back when the
+// thread exits.
+inline thread_local LinearAllocator* tlsLinearAllocator = nullptr;
+
+class ScratchArenaRegistry
+{
+	struct ThreadEntry
+	{
+		std::thread::id thread;
+		std::atomic<size_t> highWaterBytes{ 0 };
+		std::atomic<bool> running{ true };
+	};
+
+public:
+	struct ThreadReport
+	{
+		std::thread::id thread;
+		size_t highWaterBytes;
+		bool running;
+	};
+
+	// Lease of one thread, released by its thread_local destructor
+	class Lease
+	{
+	public:
+		Lease() = default;
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+
+		~Lease()
+		{
+			if (m_Arena == nullptr)
+				return;
+			if (tlsLinearAllocator == m_Arena)
+				tlsLinearAllocator = nullptr;
+			Instance().Release(m_Arena, m_Entry);
+		}
+
+		LinearAllocator* Attach()
+		{
+			if (m_Arena == nullptr)
+				m_Arena = Instance().Acquire(m_Entry);
+			return m_Arena;
+		}
+
+		// Makes the arena's high-water mark visible to Report(); called on scope exit
+		void Publish()
+		{
+			if (m_Arena == nullptr)
+				return;
+			const size_t peak = m_Arena->PeakBytes();
+			if (peak > m_Published)
+			{
+				m_Published = peak;
+				m_Entry->highWaterBytes.store(peak, std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		LinearAllocator* m_Arena = nullptr;
+		ThreadEntry* m_Entry = nullptr;
+		size_t m_Published = 0;
+	};
+
+	static ScratchArenaRegistry& Instance()
+	{
+		static ScratchArenaRegistry registry;
+		return registry;
+	}
+
+	// Block size of arenas leased from now on; idle arenas of another size are dropped
+	void SetBlockSize(size_t blockSize)
+	{
+		std::vector<std::unique_ptr<LinearAllocator>> dropped;
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_BlockSize = blockSize;
+		auto stale = std::stable_partition(m_Idle.begin(), m_Idle.end(),
+			[blockSize](const std::unique_ptr<LinearAllocator>& arena) { return arena->BlockSize() == blockSize; });
+		// Freed after the lock is released
+		dropped.assign(std::make_move_iterator(stale), std::make_move_iterator(m_Idle.end()));
+		m_Idle.erase(stale, m_Idle.end());
+	}
+
+	size_t BlockSize() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_BlockSize;
+	}
+
+	// Arenas of exited threads kept for the next threads
+	void SetMaxIdle(size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_MaxIdle = count;
+		if (m_Idle.size() > count)
+			m_Idle.resize(count);
+	}
+
+	size_t IdleCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Idle.size();
+	}
+
+	// High-water mark of every thread that leased an arena, as of its last scope exit
+	std::vector<ThreadReport> Report() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::vector<ThreadReport> report;
+		report.reserve(m_Threads.size());
+		for (const auto& entry : m_Threads)
+			report.push_back({ entry.thread, entry.highWaterBytes.load(std::memory_order_relaxed), entry.running.load(std::memory_order_relaxed) });
+		return report;
+	}
+
+	// Forgets the entries of threads that have exited
+	void ClearExited()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Threads.remove_if([](const ThreadEntry& entry) { return !entry.running.load(std::memory_order_relaxed); });
+	}
+
+private:
+	ScratchArenaRegistry() = default;
+
+	LinearAllocator* Acquire(ThreadEntry*& entry)
+	{
+		std::unique_ptr<LinearAllocator> arena;
+		size_t blockSize;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			entry = &m_Threads.emplace_back();
+			entry->thread = std::this_thread::get_id();
+			blockSize = m_BlockSize;
+			// SetBlockSize purges the others, so every idle arena has the current size
+			if (!m_Idle.empty())
+			{
+				arena = std::move(m_Idle.back());
+				m_Idle.pop_back();
+			}
+		}
+		if (!arena)
+			arena = std::make_unique<LinearAllocator>(blockSize);
+		return arena.release();
+	}
+
+	void Release(LinearAllocator* arena, ThreadEntry* entry)
+	{
+		std::unique_ptr<LinearAllocator> owned(arena);
+		owned->Reset();
+		entry->highWaterBytes.store(owned->PeakBytes(), std::memory_order_relaxed);
+		entry->running.store(false, std::memory_order_relaxed);
+
+		// Growth blocks of this thread's spikes are not kept for the next thread
+		owned->ReleaseSpare();
+		owned->ResetPeak();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Idle.size() < m_MaxIdle && owned->BlockSize() == m_BlockSize)
+			m_Idle.push_back(std::move(owned));
+	}
+
+	mutable std::mutex m_Mutex;
+	size_t m_BlockSize = 256 * 1024;
+	size_t m_MaxIdle = 64;
+	std::vector<std::unique_ptr<LinearAllocator>> m_Idle;
+	// std::list keeps entries in place while leases point at them
+	std::list<ThreadEntry> m_Threads;
+};
+
+inline thread_local ScratchArenaRegistry::Lease tlsScratchArenaLease;
+
+// The calling thread's arena, leased on first use
+inline LinearAllocator& ThreadScratchArena()
+{
+	if (tlsLinearAllocator == nullptr)
+		tlsLinearAllocator = tlsScratchArenaLease.Attach();
+	return *tlsLinearAllocator;
+}
+
+template<typename T>
+class TempStdAllocator {
+public:
+	typedef T value_type;
+	typedef value_type* pointer;
+	typedef const value_type* const_pointer;
+	typedef value_type& reference;
+	typedef const value_type& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+public:
+	template<typename U>
+	struct rebind {
+		typedef TempStdAllocator<U> other;
+	};
+
+public:
+	inline TempStdAllocator() {}
+	inline ~TempStdAllocator() {}
+	inline TempStdAllocator(const TempStdAllocator& rhs) {}
+
+	template<typename U>
+	inline TempStdAllocator(const TempStdAllocator<U>& rhs) {}
+
+	inline pointer address(reference r) { return &r; }
+	inline const_pointer address(const_reference r) { return &r; }
+
+	inline pointer allocate(size_type cnt, const void* = nullptr)
+	{
+		return reinterpret_cast<pointer>(ThreadScratchArena().Allocate(cnt * sizeof(T), Alignment));
+	}
+
+#if defined(__cpp_lib_allocate_at_least)
+	// The padding up to the next allocation is lost anyway, so hand it to the container
+	inline std::allocation_result<pointer, size_type> allocate_at_least(size_type cnt)
+	{
+		const size_type bytes = (cnt * sizeof(T) + Alignment - 1) & ~size_type(Alignment - 1);
+		return { allocate(bytes / sizeof(T)), bytes / sizeof(T) };
+	}
+#endif
+
+	// Only the top allocation (and the run freed right under it) goes back to the
+	// arena; anything else waits for the enclosing TempAllocatorScope
+	inline void deallocate(pointer p, size_type cnt)
+	{
+		ThreadScratchArena().Free(p, cnt * sizeof(T));
+	}
+
+	inline size_type max_size() const
+	{
+		return std::numeric_limits<size_type>::max() / sizeof(T);
+	}
+
+	template <class U, class... Args>
+	inline void construct(U * p, Args && ... args)
+	{
+		TEMP_NEW_INPLACE(p) U(std::forward<Args>(args)...);
+	}
+
+	inline void destroy(pointer p) { p->~T(); }
+
+	inline bool operator==(TempStdAllocator const&) const { return true; }
+	inline bool operator!=(TempStdAllocator const& a) const { return !operator==(a); }
+
+private:
+	static constexpr unsigned Alignment = sizeof(size_t) == 4 ? 8 : 16;
+
+	template<typename U> friend class TempStdAllocator;
+};
+
+struct TempAllocatorScope
+{
+public:
+	TempAllocatorScope()
+		: m_Arena(ThreadScratchArena())
+		, m_Marker(m_Arena.GetMarker())
+	{}
+
+	~TempAllocatorScope()
+	{
+		m_Arena.Rewind(m_Marker);
+		tlsScratchArenaLease.Publish();
+	}
+private:
+	LinearAllocator& m_Arena;
+	LinearAllocator::Marker m_Marker;
+};